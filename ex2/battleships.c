@@ -9,11 +9,11 @@
 
 // ------------------------------ includes ------------------------------
 #include <stdlib.h>
+#include <string.h>
 #include "battleships.h"
 
 // -------------------------- const definitions -------------------------
 
-#define NULL_COORD (-1)
 /**
  * True/False symbols
  */
@@ -32,30 +32,80 @@
 
 Boat *myBoats; //Global array for the boats
 int boardSize;
+Bitboard occupied; // the cells of all the boats
+Bitboard hits; // the cells of the boats which were hit
 
 /**
- * A function to free coord array of a boat
- * @param boat the boat we want to free coord's
+ * Get the bit of a cell in the bitboards
+ * @param x x position
+ * @param y y position
+ * @return the bit
+ */
+int cellBit(int x, int y)
+{
+    return x * boardSize + y;
+}
+
+/**
+ * Add a cell to a bitboard
+ * @param board the bitboard
+ * @param bit the bit of the cell
+ */
+void setCell(Bitboard *board, int bit)
+{
+    board->words[bit / WORD_BITS] |= (uint64_t) 1 << (bit % WORD_BITS);
+}
+
+/**
+ * Tell if a cell is in a bitboard
+ * @param board the bitboard
+ * @param bit the bit of the cell
+ * @return 1 iff it is in
  */
-void freeCoord(Boat *boat)
+int hasCell(const Bitboard *board, int bit)
 {
-    for (int i = 0; i < boat->size; i++)
+    return (board->words[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+}
+
+/**
+ * Tell if two bitboards share a cell
+ * @param first first bitboard
+ * @param second second bitboard
+ * @return 1 iff they do
+ */
+int intersects(const Bitboard *first, const Bitboard *second)
+{
+    uint64_t common = 0;
+    for (int i = 0; i < BOARD_WORDS; i++)
     {
-        free(boat->coord[i]);
+        common |= first->words[i] & second->words[i];
     }
-    free(boat->coord);
+    return common != 0;
 }
 
 /**
- * A function to free the boats array and what is included
+ * Tell if every cell of a mask is in a bitboard
+ * @param board the bitboard
+ * @param mask the mask
+ * @return 1 iff they all are
  */
-void freeBoats()
+int covers(const Bitboard *board, const Bitboard *mask)
 {
-    for (int boatIndex = 0; boatIndex < BOATS_NUMBER; boatIndex++)
+    uint64_t missing = 0;
+    for (int i = 0; i < BOARD_WORDS; i++)
     {
-        freeCoord(myBoats + boatIndex);
+        missing |= mask->words[i] & ~board->words[i];
     }
+    return missing == 0;
+}
+
+/**
+ * A function to free the boats array and what is included
+ */
+void freeBoats()
+{
     free(myBoats);
+    myBoats = NULL;
 }
 
 /**
@@ -70,17 +120,7 @@ int isAvailable(int x, int y)
     {
         return 0;
     }
-    for (int boatIndex = 0; boatIndex < BOATS_NUMBER; boatIndex++)
-    {
-        for (int i = 0; i < myBoats[boatIndex].size; i++)
-        {
-            if (myBoats[boatIndex].coord[i][0] == x && myBoats[boatIndex].coord[i][1] == y)
-            {
-                return 0;
-            }
-        }
-    }
-    return 1;
+    return !hasCell(&occupied, cellBit(x, y));
 }
 
 /**
@@ -91,23 +131,7 @@ int isAvailable(int x, int y)
 void initBoat(Boat *boat, int boatSize)
 {
     boat->size = boatSize;
-    boat->coord = (int **) malloc(sizeof(int *) * boatSize);
-    if (boat->coord == NULL)
-    {
-        freeBoats();
-        exit(1);
-    }
-    for (int i = 0; i < boatSize; i++)
-    {
-        boat->coord[i] = (int *) malloc(sizeof(int) * 2);
-        if (boat->coord[i] == NULL)
-        {
-            freeBoats();
-            exit(1);
-        }
-        boat->coord[i][0] = NULL_COORD;
-        boat->coord[i][1] = NULL_COORD;
-    }
+    memset(&boat->mask, 0, sizeof(Bitboard));
 }
 
 /**
@@ -120,41 +144,24 @@ void putBoat(Boat *boat)
     int flag = TRUE;
     while (flag)
     {
-        flag = FALSE;
+        initBoat(boat, boat->size);
         int orientation = rand() % 2;
         int x = rand() % (boardSize);
         int y = rand() % (boardSize);
-        if (orientation == 0)
+        int dx = orientation == 0 ? 1 : 0, dy = orientation == 1 ? 1 : 0;
+        if (x + dx * (boat->size - 1) >= boardSize || y + dy * (boat->size - 1) >= boardSize)
         {
-            for (int i = 0; i < boat->size; i++)
-            {
-                if (isAvailable(x + i, y) == 0)
-                {
-                    flag = TRUE;
-                    freeCoord(boat);
-                    initBoat(boat, boat->size);
-                    break;
-                }
-                boat->coord[i][0] = x + i;
-                boat->coord[i][1] = y;
-            }
+            continue;
         }
-        else if (orientation == 1)
+        for (int i = 0; i < boat->size; i++)
         {
-            for (int i = 0; i < boat->size; i++)
-            {
-                if (isAvailable(x, y + i) == 0)
-                {
-                    flag = TRUE;
-                    freeCoord(boat);
-                    initBoat(boat, boat->size);
-                    break;
-                }
-                boat->coord[i][0] = x;
-                boat->coord[i][1] = y + i;
-            }
+            setCell(&boat->mask, cellBit(x + dx * i, y + dy * i));
         }
-
+        flag = intersects(&boat->mask, &occupied);
+    }
+    for (int i = 0; i < BOARD_WORDS; i++)
+    {
+        occupied.words[i] |= boat->mask.words[i];
     }
 }
 
@@ -166,10 +173,12 @@ void init(int size)
 {
     // Creating the boats
     boardSize = size;
+    memset(&occupied, 0, sizeof(Bitboard));
+    memset(&hits, 0, sizeof(Bitboard));
     myBoats = (Boat *) malloc(BOATS_NUMBER * sizeof(Boat));
     if (myBoats == NULL)
     {
-        free(myBoats);
+        exit(1);
     }
     initBoat(myBoats, BOAT1_SIZE);
     initBoat(myBoats + 1, BOAT2_SIZE);
@@ -191,23 +200,20 @@ void init(int size)
  */
 int shot(int x, int y)
 {
+    int bit = cellBit(x, y);
+    if (!hasCell(&occupied, bit))
+    {
+        return MISS;
+    }
+    int again = hasCell(&hits, bit);
+    setCell(&hits, bit);
     for (int boatIndex = 0; boatIndex < BOATS_NUMBER; boatIndex++)
     {
-        for (int i = 0; i < myBoats[boatIndex].size; i++)
+        if (hasCell(&myBoats[boatIndex].mask, bit))
         {
-            if (myBoats[boatIndex].coord[i][0] == x && myBoats[boatIndex].coord[i][1] == y)
-            {
-                (myBoats + boatIndex)->count++;
-                if (myBoats[boatIndex].count == myBoats[boatIndex].size)
-                {
-                    return SUNK;
-                }
-                else
-                {
-                    return HIT;
-                }
-            }
+            // A boat sinks once, with its last cell hit
+            return !again && covers(&hits, &myBoats[boatIndex].mask) ? SUNK : HIT;
         }
     }
-    return MISS;
+    return HIT;
 }
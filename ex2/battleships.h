@@ -12,16 +12,34 @@
 #define SUNK 2
 #define HIT 1
 #define MISS 0
+/**
+ * Bitboards: a bit per cell of a board of at most MAX_BOARD_SIZE x MAX_BOARD_SIZE, row after row
+ */
+#define MAX_BOARD_SIZE 25
+#define WORD_BITS 64
+#define BOARD_WORDS ((MAX_BOARD_SIZE * MAX_BOARD_SIZE + WORD_BITS - 1) / WORD_BITS)
 #ifndef EX2_BATTLESHIPS_H
 #define EX2_BATTLESHIPS_H
 
+#include <stdint.h>
+
 // ------------------------------ functions -----------------------------
 
+/**
+ * A set of cells of the board, bit x * size + y of words for the cell (x, y)
+ */
+typedef struct Bitboard
+{
+    uint64_t words[BOARD_WORDS];
+} Bitboard;
+
+/**
+ * A boat: its size and the mask of its cells
+ */
 typedef struct Boat
 {
     int size;
-    int **coord;
-    int count;
+    Bitboard mask;
 } Boat;
 
 /**
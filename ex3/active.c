@@ -0,0 +1,197 @@
+/**
+ * @file active.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Sweeps which skip the blocks of a grid that would not change. A block is updated when it
+ * or one of its 4 neighbor blocks changed since its last update: in an in place sweep, the
+ * blocks before it (in row order) changed in this sweep, the others in the previous one, and
+ * in a Jacobi sweep every block reads the previous sweep.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <string.h>
+#include "active.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+// ------------------------------ structs -----------------------------
+
+/**
+ * The map: moved[current] holds the blocks which changed in the current sweep, and
+ * moved[1 - current] those of the previous one, blocks per row, row after row. before holds
+ * the cells of a block before an in place update.
+ */
+struct active_map
+{
+    size_t n, m, blocks;
+    int is_cyclic;
+    unsigned char *moved[2];
+    int current;
+    double before[ACTIVE_WIDTH];
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Create the map of a grid, where every block is to be updated
+ * @param n height of the grid
+ * @param m width of the grid
+ * @param is_cyclic tell how to deal with borders
+ * @return the map, or NULL if it could not be allocated
+ */
+active_map *createActiveMap(size_t n, size_t m, int is_cyclic)
+{
+    active_map *map = (active_map *) malloc(sizeof(active_map));
+    if (map == NULL)
+    {
+        return NULL;
+    }
+    map->n = n;
+    map->m = m;
+    map->blocks = (m + ACTIVE_WIDTH - 1) / ACTIVE_WIDTH;
+    map->is_cyclic = is_cyclic >= TRUE;
+    map->current = 0;
+    size_t count = n * map->blocks > 0 ? n * map->blocks : 1;
+    map->moved[0] = (unsigned char *) malloc(count);
+    map->moved[1] = (unsigned char *) malloc(count);
+    if (map->moved[0] == NULL || map->moved[1] == NULL)
+    {
+        freeActiveMap(map);
+        return NULL;
+    }
+    resetActiveMap(map);
+    return map;
+}
+
+/**
+ * Mark every block of a map to be updated, as in a new map (after the grid was written)
+ * @param map the map
+ */
+void resetActiveMap(active_map *map)
+{
+    size_t count = map->n * map->blocks > 0 ? map->n * map->blocks : 1;
+    // As if everything changed before the first sweep
+    memset(map->moved[0], TRUE, count);
+    memset(map->moved[1], TRUE, count);
+}
+
+/**
+ * Free a map
+ * @param map the map (may be NULL)
+ */
+void freeActiveMap(active_map *map)
+{
+    if (map == NULL)
+    {
+        return;
+    }
+    free(map->moved[0]);
+    free(map->moved[1]);
+    free(map);
+}
+
+/**
+ * Tell if a block changed since the last update of another one
+ * @param map the map
+ * @param i row of the block being updated
+ * @param c column of the block being updated
+ * @param row row of the block
+ * @param column column of the block
+ * @param inPlace 1 for an in place sweep
+ * @return 1 iff the block changed
+ */
+int hasMoved(const active_map *map, size_t i, size_t c, size_t row, size_t column, int inPlace)
+{
+    int updated = inPlace && (row < i || (row == i && column < c));
+    return map->moved[updated ? map->current : 1 - map->current][row * map->blocks + column];
+}
+
+/**
+ * Tell if a block may change: if it or one of its neighbors changed since its last update
+ * @param map the map
+ * @param i row of the block
+ * @param c column of the block
+ * @param inPlace 1 for an in place sweep
+ * @return 1 iff the block has to be updated
+ */
+int isActive(const active_map *map, size_t i, size_t c, int inPlace)
+{
+    size_t n = map->n, blocks = map->blocks;
+    int cyclic = map->is_cyclic;
+    return hasMoved(map, i, c, i, c, inPlace)
+           || ((i > 0 || cyclic) && hasMoved(map, i, c, i > 0 ? i - 1 : n - 1, c, inPlace))
+           || ((i + 1 < n || cyclic)
+               && hasMoved(map, i, c, i + 1 < n ? i + 1 : 0, c, inPlace))
+           || ((c > 0 || cyclic)
+               && hasMoved(map, i, c, i, c > 0 ? c - 1 : blocks - 1, inPlace))
+           || ((c + 1 < blocks || cyclic)
+               && hasMoved(map, i, c, i, c + 1 < blocks ? c + 1 : 0, inPlace));
+}
+
+/**
+ * Update the rows [from, to) of the grid, except the blocks which would not change
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param map the map of the grid, updated
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void sweepActive(diff_func function, heat_interior_func interior, heat_grid *dst,
+                 const heat_grid *src, const source_index *index, active_map *map,
+                 size_t from, size_t to, residual *change)
+{
+    int inPlace = dst == src;
+    for (size_t i = from; i < to; i++)
+    {
+        unsigned char *moved = map->moved[map->current] + i * map->blocks;
+        size_t c = 0;
+        while (c < map->blocks)
+        {
+            if (!isActive(map, i, c, inPlace))
+            {
+                moved[c++] = FALSE;
+                continue;
+            }
+            // A Jacobi sweep updates the next active blocks too in one go, which keeps the
+            // vector sweeps long. An in place block reads the change of the block before it.
+            size_t end = c + 1;
+            while (!inPlace && end < map->blocks && isActive(map, i, end, inPlace))
+            {
+                end++;
+            }
+            size_t first = c * ACTIVE_WIDTH;
+            size_t last = end * ACTIVE_WIDTH < map->m ? end * ACTIVE_WIDTH : map->m;
+            // The cells of the blocks before the update, from the cell first
+            const double *before = GRID_ROW(src, i) + first;
+            if (inPlace)
+            {
+                memcpy(map->before, before, (last - first) * sizeof(double));
+                before = map->before;
+            }
+            updateBlock(function, interior, dst, src, index, map->is_cyclic, i, first, last,
+                        change);
+            const double *after = GRID_ROW(dst, i);
+            for (; c < end; c++)
+            {
+                size_t start = c * ACTIVE_WIDTH;
+                size_t stop = start + ACTIVE_WIDTH < map->m ? start + ACTIVE_WIDTH : map->m;
+                moved[c] = memcmp(before + (start - first), after + start,
+                                  (stop - start) * sizeof(double)) != 0;
+            }
+        }
+    }
+}
+
+/**
+ * End a sweep of every row: its changes become those of the previous sweep
+ * @param map the map
+ */
+void endActiveSweep(active_map *map)
+{
+    map->current = 1 - map->current;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file active.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Tracking of the parts of a grid which still change
+ * @section DESCRIPTION
+ * Every row is split into blocks of ACTIVE_WIDTH cells, and the map keeps which blocks changed
+ * in their last update. A block which did not change, and whose neighbor blocks did not change
+ * since its last update, reads the same values as then, so it would not change again: a sweep
+ * skips it. The first sweep updates every block. With a few sources on a big grid, only the
+ * blocks the heat reached are updated, and the map grows with the heat.
+ * The skipped blocks are exactly those which would not change, so the grid is the one of full
+ * sweeps (and so is the diff of an in place sweep, whose cells are still updated in order).
+ */
+#ifndef ACTIVE_H
+#define ACTIVE_H
+
+#include "kernel.h"
+
+// -------------------------- const definitions -------------------------
+/**
+ * Number of cells of a block.
+ */
+#define ACTIVE_WIDTH 128
+
+/**
+ * Which blocks of a grid changed in the previous sweep and in the current one.
+ */
+typedef struct active_map active_map;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Create the map of a grid, where every block is to be updated
+ * @param n height of the grid
+ * @param m width of the grid
+ * @param is_cyclic tell how to deal with borders
+ * @return the map, or NULL if it could not be allocated
+ */
+active_map *createActiveMap(size_t n, size_t m, int is_cyclic);
+
+/**
+ * Mark every block of a map to be updated, as in a new map (after the grid was written)
+ * @param map the map
+ */
+void resetActiveMap(active_map *map);
+
+/**
+ * Free a map
+ * @param map the map (may be NULL)
+ */
+void freeActiveMap(active_map *map);
+
+/**
+ * Update the rows [from, to) of the grid, except the blocks which would not change.
+ * The threads of a Jacobi sweep may update their rows at the same time, an in place sweep
+ * runs on one thread.
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param map the map of the grid, updated
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void sweepActive(diff_func function, heat_interior_func interior, heat_grid *dst,
+                 const heat_grid *src, const source_index *index, active_map *map,
+                 size_t from, size_t to, residual *change);
+
+/**
+ * End a sweep of every row: its changes become those of the previous sweep
+ * @param map the map
+ */
+void endActiveSweep(active_map *map);
+
+#endif
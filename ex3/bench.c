@@ -0,0 +1,405 @@
+/**
+ * @file bench.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Benchmark of calculate. The cases are square grids of 64 to 8192 cells a side, with 0 to
+ * 10000 sources, with and without cyclic borders. Every case runs calculate for a fixed number
+ * of iterations, a few times from the same grid (after a run to warm up). Its median and 95th
+ * percentile times are compared with those of a baseline file: a median slower than the
+ * baseline by more than TOLERANCE is a regression. The times depend on the machine, so the
+ * baseline is written on the machine it is compared on.
+ * heat_bench <baseline> [largest size] compares with the baseline, and exits with 1 if a case
+ * regressed. heat_bench --save <baseline> [largest size] writes the baseline instead.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "calculator.h"
+#include "heat_eqn.h"
+#include "profile.h"
+// -------------------------- const definitions -------------------------
+#define ERROR_MSG "error"
+#define SAVE_FLAG "--save"
+#define CORRECT_USAGE "correct usage is [" SAVE_FLAG "] <baseline> [largest size]"
+#define SIZE_COUNT 5
+#define SOURCE_COUNTS 3
+#define LARGEST_SIZE 8192
+/**
+ * Every case runs BENCH_ITERATIONS iterations (and the last one, see calculate)
+ */
+#define BENCH_ITERATIONS 20
+/**
+ * A case is repeated until about BENCH_WORK cells were updated, within the bounds
+ */
+#define BENCH_WORK 268435456.0
+#define MIN_REPEATS 3
+#define MAX_REPEATS 25
+#define PERCENTILE 0.95
+#define TOLERANCE 0.15
+/**
+ * The k-th source is at the cell k * SOURCE_STEP (modulo the cells): SOURCE_STEP is odd, so
+ * the sources of a grid of 2^k cells are all distinct
+ */
+#define SOURCE_STEP 2654435761UL
+#define SOURCE_VALUES 201
+#define SOURCE_OFFSET 100
+#define CASE_NAME_FORMAT "%zu %zu %d"
+#define BASELINE_FORMAT "%zu %zu %d %lf %lf"
+#define BASELINE_FIELDS 5
+#define BASELINE_HEADER "# size sources cyclic median p95 (seconds)\n"
+#define CASE_FORMAT "%5zu^2 %5zu sources %-10s median %10.6f s  p95 %10.6f s"
+#define COMPARE_FORMAT "  baseline %10.6f s %+7.1f%%%s\n"
+#define REGRESSION_MARK "  REGRESSION"
+#define NEW_CASE "  (no baseline)\n"
+#define SUMMARY_FORMAT "%lu of %lu cases regressed by more than %.0f%%\n"
+#define LINE_LENGTH 256
+#define TRUE 1
+#define FALSE 0
+// ------------------------------ structs -----------------------------
+
+/**
+ * A case: the side of the grid, its sources and borders, and its times.
+ */
+typedef struct
+{
+    size_t size, sources;
+    int cyclic;
+    double median, p95;
+} bench_case;
+
+/**
+ * The cases of a baseline file.
+ */
+typedef struct
+{
+    bench_case *cases;
+    size_t count;
+} bench_baseline;
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Place the sources of a case
+ * @param sources the sources to set
+ * @param count number of sources
+ * @param size side of the grid (a power of 2)
+ */
+void placeBenchSources(source_point *sources, size_t count, size_t size)
+{
+    size_t cells = size * size;
+    for (size_t k = 0; k < count; k++)
+    {
+        size_t cell = (size_t) ((k * SOURCE_STEP) % cells);
+        sources[k].x = (int) (cell / size);
+        sources[k].y = (int) (cell % size);
+        sources[k].value = (double) ((k * SOURCE_STEP) % SOURCE_VALUES) - SOURCE_OFFSET;
+    }
+}
+
+/**
+ * Set a grid to zero, except its sources
+ * @param grid the rows of the grid
+ * @param size side of the grid
+ * @param sources the sources
+ * @param count number of sources
+ */
+void resetBenchGrid(double **grid, size_t size, const source_point *sources, size_t count)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        memset(grid[i], 0, size * sizeof(double));
+    }
+    for (size_t k = 0; k < count; k++)
+    {
+        grid[sources[k].x][sources[k].y] = sources[k].value;
+    }
+}
+
+/**
+ * Order two times, for qsort
+ * @param a the first time
+ * @param b the second time
+ * @return negative, 0 or positive as a is shorter, as long or longer than b
+ */
+int compareTimes(const void *a, const void *b)
+{
+    double first = *(const double *) a, second = *(const double *) b;
+    return (first > second) - (first < second);
+}
+
+/**
+ * Set the median and the 95th percentile (nearest rank) of the times of a case
+ * @param bench the case
+ * @param times the times (sorted here)
+ * @param count number of times (at least 1)
+ */
+void summariseTimes(bench_case *bench, double *times, size_t count)
+{
+    qsort(times, count, sizeof(double), compareTimes);
+    bench->median = count % 2 == 1 ? times[count / 2]
+                                   : (times[count / 2 - 1] + times[count / 2]) / 2;
+    size_t rank = (size_t) ceil(PERCENTILE * (double) count);
+    bench->p95 = times[rank - 1];
+}
+
+/**
+ * Run a case
+ * @param bench the case, its times are set
+ * @param grid rows of a grid of the size of the case
+ * @return 1 iff every run of calculate succeeded
+ */
+int runCase(bench_case *bench, double **grid)
+{
+    size_t size = bench->size, cells = size * size;
+    double work = (double) cells * (BENCH_ITERATIONS + 1);
+    size_t repeats = (size_t) (BENCH_WORK / work);
+    repeats = repeats < MIN_REPEATS ? MIN_REPEATS
+                                    : repeats > MAX_REPEATS ? MAX_REPEATS : repeats;
+    // One more source, so that malloc is not asked for 0 bytes
+    source_point *sources = (source_point *) malloc(sizeof(source_point)
+                                                    * (bench->sources + 1));
+    double *times = (double *) malloc(sizeof(double) * repeats);
+    int done = sources != NULL && times != NULL;
+    if (done)
+    {
+        placeBenchSources(sources, bench->sources, size);
+    }
+    // The first run only warms up the caches and the allocator
+    for (size_t r = 0; done && r <= repeats; r++)
+    {
+        resetBenchGrid(grid, size, sources, bench->sources);
+        double start = profileClock();
+        done = calculate(heat_eqn, grid, size, size, sources, bench->sources, 0,
+                         BENCH_ITERATIONS, bench->cyclic) >= 0;
+        if (r > 0)
+        {
+            times[r - 1] = profileClock() - start;
+        }
+    }
+    if (done)
+    {
+        summariseTimes(bench, times, repeats);
+    }
+    free(sources);
+    free(times);
+    return done;
+}
+
+/**
+ * Read a baseline file
+ * @param path the file
+ * @param baseline the baseline to fill
+ * @return 1 iff the file could be read
+ */
+int readBaseline(const char *path, bench_baseline *baseline)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return FALSE;
+    }
+    size_t capacity = 0;
+    int valid = TRUE;
+    char line[LINE_LENGTH];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        bench_case bench;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+        {
+            continue;
+        }
+        if (sscanf(line, BASELINE_FORMAT, &bench.size, &bench.sources, &bench.cyclic,
+                   &bench.median, &bench.p95) != BASELINE_FIELDS)
+        {
+            valid = FALSE;
+            break;
+        }
+        if (baseline->count == capacity)
+        {
+            capacity = capacity > 0 ? 2 * capacity : SIZE_COUNT * SOURCE_COUNTS * 2;
+            bench_case *cases = (bench_case *) realloc(baseline->cases,
+                                                       sizeof(bench_case) * capacity);
+            if (cases == NULL)
+            {
+                valid = FALSE;
+                break;
+            }
+            baseline->cases = cases;
+        }
+        baseline->cases[baseline->count++] = bench;
+    }
+    fclose(file);
+    return valid;
+}
+
+/**
+ * Find a case in a baseline
+ * @param baseline the baseline
+ * @param bench the case
+ * @return the case of the baseline, or NULL if it has none
+ */
+const bench_case *findCase(const bench_baseline *baseline, const bench_case *bench)
+{
+    for (size_t k = 0; k < baseline->count; k++)
+    {
+        const bench_case *other = &baseline->cases[k];
+        if (other->size == bench->size && other->sources == bench->sources
+            && other->cyclic == bench->cyclic)
+        {
+            return other;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Report a case, compared with the baseline
+ * @param bench the case
+ * @param baseline the baseline, NULL when it is being written
+ * @return 1 iff the case regressed
+ */
+int reportCase(const bench_case *bench, const bench_baseline *baseline)
+{
+    printf(CASE_FORMAT, bench->size, bench->sources, bench->cyclic ? "cyclic" : "bounded",
+           bench->median, bench->p95);
+    const bench_case *before = baseline != NULL ? findCase(baseline, bench) : NULL;
+    if (before == NULL)
+    {
+        printf(baseline != NULL ? NEW_CASE : "\n");
+        return FALSE;
+    }
+    double change = before->median > 0 ? bench->median / before->median - 1 : 0;
+    int regressed = change > TOLERANCE;
+    printf(COMPARE_FORMAT, before->median, 100 * change, regressed ? REGRESSION_MARK : "");
+    return regressed;
+}
+
+/**
+ * Run every case up to a size
+ * @param largest the largest side of the grids
+ * @param baseline the baseline to compare with, NULL to write one
+ * @param file the baseline file to write, NULL to compare
+ * @param regressions set to the number of cases which regressed
+ * @param count set to the number of cases
+ * @return 1 iff every case could run
+ */
+int runCases(size_t largest, const bench_baseline *baseline, FILE *file,
+             unsigned long *regressions, unsigned long *count)
+{
+    size_t sizes[SIZE_COUNT] = {64, 256, 1024, 4096, 8192};
+    size_t sources[SOURCE_COUNTS] = {0, 100, 10000};
+    *regressions = 0;
+    *count = 0;
+    for (int s = 0; s < SIZE_COUNT && sizes[s] <= largest; s++)
+    {
+        size_t size = sizes[s];
+        double **grid = (double **) malloc(sizeof(double *) * size);
+        double *cells = (double *) malloc(sizeof(double) * size * size);
+        if (grid == NULL || cells == NULL)
+        {
+            free(grid);
+            free(cells);
+            return FALSE;
+        }
+        for (size_t i = 0; i < size; i++)
+        {
+            grid[i] = cells + i * size;
+        }
+        int done = TRUE;
+        for (int k = 0; done && k < SOURCE_COUNTS; k++)
+        {
+            for (int cyclic = 0; done && cyclic < 2; cyclic++)
+            {
+                // At most a source in every 4 cells
+                bench_case bench = {size, sources[k] < size * size / 4 ? sources[k]
+                                                                      : size * size / 4,
+                                    cyclic, 0, 0};
+                done = runCase(&bench, grid);
+                if (done)
+                {
+                    *regressions += (unsigned long) reportCase(&bench, baseline);
+                    (*count)++;
+                    fflush(stdout);
+                }
+                if (done && file != NULL)
+                {
+                    fprintf(file, CASE_NAME_FORMAT " %.9f %.9f\n", bench.size, bench.sources,
+                            bench.cyclic, bench.median, bench.p95);
+                }
+            }
+        }
+        free(grid);
+        free(cells);
+        if (!done)
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * main function
+ * @param argc number of args
+ * @param argv args array
+ * @return 0 if no case regressed
+ */
+int main(int argc, char *argv[])
+{
+    int save = argc > 1 && strcmp(argv[1], SAVE_FLAG) == 0;
+    int first = save ? 2 : 1;
+    if (argc < first + 1 || argc > first + 2)
+    {
+        fprintf(stderr, CORRECT_USAGE);
+        exit(1);
+    }
+    long largest = LARGEST_SIZE;
+    if (argc == first + 2)
+    {
+        char *end;
+        largest = strtol(argv[first + 1], &end, 10);
+        if (*end != '\0' || largest < 1)
+        {
+            fprintf(stderr, CORRECT_USAGE);
+            exit(1);
+        }
+    }
+    bench_baseline baseline = {NULL, 0};
+    FILE *file = NULL;
+    if (save)
+    {
+        file = fopen(argv[first], "w");
+    }
+    if ((save && (file == NULL || fputs(BASELINE_HEADER, file) < 0))
+        || (!save && !readBaseline(argv[first], &baseline)))
+    {
+        fprintf(stderr, ERROR_MSG);
+        free(baseline.cases);
+        if (file != NULL)
+        {
+            fclose(file);
+        }
+        exit(1);
+    }
+    unsigned long regressions, count;
+    int done = runCases((size_t) largest, save ? NULL : &baseline, file, &regressions, &count);
+    free(baseline.cases);
+    if (file != NULL)
+    {
+        done = fclose(file) == 0 && done;
+    }
+    if (!done)
+    {
+        fprintf(stderr, ERROR_MSG);
+        exit(1);
+    }
+    if (!save)
+    {
+        printf(SUMMARY_FORMAT, regressions, count, 100 * TOLERANCE);
+    }
+    return regressions > 0 ? 1 : 0;
+}
@@ -9,181 +9,1356 @@
 // ------------------------------ includes ------------------------------
 #include <stdio.h>
 #include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "active.h"
 #include "calculator.h"
+#include "distributed.h"
+#include "heat_eqn.h"
+#include "kernel.h"
+#include "multigrid.h"
+#include "numa.h"
+#include "outofcore.h"
+#include "parallel.h"
+#include "stencil.h"
+#include "tiling.h"
 // -------------------------- const definitions -------------------------
 #define TRUE 1
 #define FALSE 0
-// ------------------------------ macros -----------------------------
-#define UNUSED(x) (void)(x)
+// ------------------------------ structs -----------------------------
+
+/**
+ * State of a calculation shared by the threads which run it.
+ */
+typedef struct
+{
+    diff_func function;
+    heat_interior_func interior;
+    heat_interior32_func interior32;
+    update_scheme scheme;
+    unsigned int threads;
+    size_t tile; // iterations of a band, 0 for no temporal blocking
+    heat_grid *grids[2]; // grids[current] holds the latest values
+    float_grid *floats[2]; // used instead of grids in a lower precision
+    sum_mode sum;
+    active_map *active; // NULL to update every cell
+    stencil_kernel *stencil; // NULL to apply the function
+    int current;
+    source_index *index;
+    int is_cyclic;
+    double terminate;
+    double last; // the last iteration, INFINITY for no limit
+    convergence_norm norm;
+    unsigned int check_every;
+    checkpoint_func checkpoint;
+    void *checkpoint_arg;
+    unsigned int checkpoint_every;
+    thread_pool *pool;
+    residual *partial; // change of the rows of every thread
+    double diff, iteration;
+    int stop, failed;
+    heat_profile *profile; // NULL for none
+    double mark, cells, cell_flops, cell_bytes; // time of the last sweep, estimates of a sweep
+    numa_layout *layout; // NULL when the threads are not pinned
+    int pinned; // the threads of the pool are pinned
+    progress_func progress; // NULL for no reports
+    void *progress_arg;
+    unsigned int progress_every;
+    double progress_mark, progress_from, progress_cells; // time and iteration of the last report
+    cancel_flag *cancel; // NULL when the calculation cannot be cancelled
+    int cancelled;
+} calc_run;
+
+/**
+ * A calculation kept between runs, with the profile of its runs.
+ */
+struct calc_session
+{
+    calc_run run;
+    heat_profile *profile;
+};
+
+/**
+ * A grid first touched by the threads of a pool.
+ */
+typedef struct
+{
+    heat_grid *grid;
+    unsigned int threads;
+} touch_run;
+
 // ------------------------------ functions -----------------------------
+
 /**
- * Check if a point is a source
- * @param sources list of the sources
- * @param num_sources size of the list
- * @param x x
- * @param y y
- * @return 1 iff source
+ * Set the default options: in place update on the calling thread
+ * @param options the options
+ */
+void initOptions(calc_options *options)
+{
+    options->scheme = SCHEME_GAUSS_SEIDEL;
+    options->threads = 1;
+    options->simd = SIMD_AUTO;
+    options->check_simd = FALSE;
+    options->tile = 0;
+    options->norm = NORM_SUM;
+    options->check_every = 1;
+    options->start_iteration = 0;
+    options->checkpoint = NULL;
+    options->checkpoint_arg = NULL;
+    options->checkpoint_every = 0;
+    options->band = DISK_BAND;
+    options->precision = PRECISION_DOUBLE;
+    options->check_precision = FALSE;
+    options->drift = NULL;
+    options->sparse = FALSE;
+    options->stencil.count = 0;
+    options->profile = NULL;
+    options->processes = 1;
+    options->numa = FALSE;
+    options->progress = NULL;
+    options->progress_arg = NULL;
+    options->progress_every = 1;
+    options->cancel = NULL;
+}
+
+/**
+ * Tell if the change of an iteration is compared with terminate
+ * @param run the calculation
+ * @param iteration the iteration (from 1)
+ * @return 1 iff it is checked
+ */
+int isChecked(const calc_run *run, double iteration)
+{
+    return run->check_every <= 1 || fmod(iteration, run->check_every) == 0;
+}
+
+/**
+ * Tell if an iteration measures the norms of its changes: only when the norm is not the sum,
+ * and the iteration is checked or the last one (its diff is returned)
+ * @param run the calculation
+ * @param iteration the iteration (from 1)
+ * @return 1 iff the norms are needed
+ */
+int needsNorms(const calc_run *run, double iteration)
+{
+    return run->norm != NORM_SUM
+           && (isChecked(run, iteration) || iteration >= run->last);
+}
+
+/**
+ * Measure a change
+ * @param norm the measure
+ * @param change the change of an iteration
+ * @return the measure of the change
+ */
+double measureChange(convergence_norm norm, const residual *change)
+{
+    switch (norm)
+    {
+        case NORM_L1:
+            return change->l1;
+        case NORM_L2:
+            return sqrt(change->l2);
+        case NORM_LINF:
+            return change->linf;
+        default:
+            return fabs(change->delta - change->carry);
+    }
+}
+
+/**
+ * Get the first row of a thread (the rows are split evenly in thread order)
+ * @param n height of the grid
+ * @param thread the thread
+ * @param threads number of threads
+ * @return the first row of the thread, which is the end row of the previous one
+ */
+size_t firstRow(size_t n, unsigned int thread, unsigned int threads)
+{
+    return n * thread / threads;
+}
+
+/**
+ * The part of one thread in a red-black iteration: both colours of its rows, with a barrier
+ * between them. In a cyclic grid with an odd height, the first and last rows have the same
+ * colours and read each other, so thread 0 updates the last row after its own ones (allocRun
+ * gives every thread a row at least, so thread 0 owns the first row).
+ * @param run the calculation
+ * @param thread the thread
  */
-int isSource(source_point *sources, size_t num_sources, int x, int y)
+void sweepColours(calc_run *run, unsigned int thread)
 {
-    for (int i = 0; i < (int)num_sources; i++)
+    unsigned int threads = poolSize(run->pool);
+    heat_grid *grid = run->grids[0];
+    size_t n = grid->n;
+    size_t from = firstRow(n, thread, threads), to = firstRow(n, thread + 1, threads);
+    int wrapLast = run->is_cyclic >= TRUE && n % 2 == 1 && n > 1 && threads > 1;
+    if (wrapLast && thread == threads - 1)
     {
-        if (sources[i].x == x && sources[i].y == y)
+        to = from < n - 1 ? n - 1 : from;
+    }
+    residual *change = &run->partial[thread];
+    clearChange(change, needsNorms(run, run->iteration + 1));
+    // Thread 0 also updates the rows [last, n), none when there is no wrapped row
+    size_t last = wrapLast && thread == 0 ? n - 1 : n;
+    change->mode = run->sum;
+    for (int colour = 0; colour < 2; colour++)
+    {
+        if (run->floats[0] != NULL)
         {
-            return TRUE;
+            updateColourFloat(run->function, run->floats[0], run->index, run->is_cyclic, from,
+                              to, colour, change);
+            updateColourFloat(run->function, run->floats[0], run->index, run->is_cyclic, last,
+                              n, colour, change);
+        }
+        else
+        {
+            updateColour(run->function, grid, run->index, run->is_cyclic, from, to, colour,
+                         change);
+            updateColour(run->function, grid, run->index, run->is_cyclic, last, n, colour,
+                         change);
+        }
+        if (colour == 0)
+        {
+            poolBarrier(run->pool);
         }
     }
-    return FALSE;
 }
 
 /**
- * Get the right neighbor
- * @param grid the grid
- * @param m width of the grid
- * @param is_cyclic tell how to deal with borders
- * @param i i coord
- * @param j j coord
- * @return value of the neighbor
+ * The part of one thread in an iteration: update its rows and keep their change
+ * @param run the calculation
+ * @param thread the thread
  */
-double getRight(double **grid, size_t m, int is_cyclic, int i, int j)
+void sweepRows(calc_run *run, unsigned int thread)
 {
-    if (is_cyclic >= TRUE || j + 1 < (int)m)
+    if (run->scheme == SCHEME_RED_BLACK)
     {
-        return grid[i][(j + 1) % m];
+        sweepColours(run, thread);
+        return;
     }
-    else
+    unsigned int threads = poolSize(run->pool);
+    size_t n = run->grids[0]->n;
+    int next = run->scheme == SCHEME_JACOBI ? 1 - run->current : run->current;
+    residual *change = &run->partial[thread];
+    clearChange(change, needsNorms(run, run->iteration + 1));
+    change->mode = run->sum;
+    if (run->floats[0] != NULL)
+    {
+        updateRowsFloat(run->function, run->interior32, run->floats[next],
+                        run->floats[run->current], run->index, run->is_cyclic,
+                        firstRow(n, thread, threads), firstRow(n, thread + 1, threads), change);
+        return;
+    }
+    heat_grid *src = run->grids[run->current];
+    heat_grid *dst = run->grids[next];
+    if (run->stencil != NULL)
     {
-        return 0;
+        updateStencilRows(run->stencil, dst, src, run->index, run->is_cyclic,
+                          firstRow(n, thread, threads), firstRow(n, thread + 1, threads),
+                          change);
+        return;
     }
+    if (run->active != NULL)
+    {
+        sweepActive(run->function, run->interior, dst, src, run->index, run->active,
+                    firstRow(n, thread, threads), firstRow(n, thread + 1, threads), change);
+        return;
+    }
+    updateRows(run->function, run->interior, dst, src, run->index, run->is_cyclic,
+               firstRow(n, thread, threads), firstRow(n, thread + 1, threads), change);
+}
 
+/**
+ * Start the progress reports of a calculation, if it has a progress function
+ * @param run the calculation
+ * @param cells cells updated by a sweep
+ */
+void startProgress(calc_run *run, double cells)
+{
+    if (run->progress == NULL)
+    {
+        return;
+    }
+    run->progress_cells = cells;
+    run->progress_from = run->iteration;
+    run->progress_mark = profileClock();
 }
 
 /**
- * Get the left neighbor
- * @param grid the grid
- * @param m width of the grid
- * @param is_cyclic tell how to deal with borders
- * @param i i coord
- * @param j j coord
- * @return value of the neighbor
+ * Report the progress of a calculation every progress_every iterations, if it has a progress
+ * function. The time of the report is not counted in the next one.
+ * @param run the calculation
  */
-double getLeft(double **grid, size_t m, int is_cyclic, int i, int j)
+void reportProgress(calc_run *run)
 {
+    if (run->progress == NULL
+        || (run->progress_every > 1 && fmod(run->iteration, run->progress_every) != 0))
+    {
+        return;
+    }
+    double seconds = profileClock() - run->progress_mark;
+    double cells = run->progress_cells * (run->iteration - run->progress_from);
+    run->progress(run->progress_arg, (unsigned long) run->iteration, run->diff,
+                  seconds > 0 ? cells / seconds : 0);
+    run->progress_from = run->iteration;
+    run->progress_mark = profileClock();
+}
 
-    if (is_cyclic >= TRUE || j - 1 >= 0)
+/**
+ * Count an iteration, and check the stop conditions
+ * @param run the calculation
+ * @param change the change of the grid in the iteration. The diff is kept from the last
+ * measured iteration when the norms of this one were not needed.
+ */
+void checkIteration(calc_run *run, const residual *change)
+{
+    run->iteration++;
+    if (run->norm == NORM_SUM || change->norms)
     {
-        return grid[i][(j - 1 + m) % m];
+        run->diff = measureChange(run->norm, change);
+    }
+    run->stop = run->iteration >= run->last
+                || (isChecked(run, run->iteration) && run->diff < run->terminate);
+    if (!run->stop && run->cancel != NULL && isCancelled(run->cancel))
+    {
+        run->stop = TRUE;
+        run->cancelled = TRUE;
+    }
+    reportProgress(run);
+}
+
+/**
+ * Start the profile of a calculation, if it has one
+ * @param run the calculation
+ * @param profile the profile, NULL for none
+ * @param cells cells updated by a sweep
+ * @param cellFlops estimate of the floating point operations per cell updated
+ * @param cellBytes estimate of the bytes moved per cell updated
+ */
+void startProfile(calc_run *run, heat_profile *profile, double cells, double cellFlops,
+                  double cellBytes)
+{
+    run->profile = profile;
+    if (profile == NULL)
+    {
+        return;
+    }
+    run->cells = cells;
+    run->cell_flops = cellFlops;
+    run->cell_bytes = cellBytes;
+    run->mark = profileClock();
+}
+
+/**
+ * Add the sweeps since the previous ones to the profile of a calculation, if it has one
+ * @param run the calculation
+ * @param sweeps number of sweeps
+ */
+void profileSweeps(calc_run *run, unsigned long sweeps)
+{
+    if (run->profile == NULL || sweeps == 0)
+    {
+        return;
+    }
+    double now = profileClock();
+    addSweeps(run->profile, sweeps, now - run->mark, run->cells, run->cell_flops,
+              run->cell_bytes);
+    run->mark = now;
+}
+
+/**
+ * Add the bytes moved by the sweeps of every thread (or process) of a calculation to the node
+ * of its processor, if the calculation has a profile
+ * @param run the calculation
+ * @param layout the layout of the threads, NULL for none
+ * @param threads number of threads sharing the rows
+ * @param sweeps number of sweeps
+ */
+void profileNodes(calc_run *run, const numa_layout *layout, unsigned int threads,
+                  unsigned long sweeps)
+{
+    if (run->profile == NULL || layout == NULL)
+    {
+        return;
+    }
+    size_t n = run->grids[0]->n, m = run->grids[0]->m;
+    for (unsigned int thread = 0; thread < threads; thread++)
+    {
+        double rows = (double) (firstRow(n, thread + 1, threads) - firstRow(n, thread, threads));
+        addNodeBytes(run->profile, threadNode(layout, thread, threads),
+                     rows * (double) m * run->cell_bytes * (double) sweeps);
+    }
+}
+
+/**
+ * The part of one thread in the first touch of a grid: zero its rows
+ * @param arg the grid (touch_run)
+ * @param thread the thread
+ */
+void touchRows(void *arg, unsigned int thread)
+{
+    touch_run *touch = (touch_run *) arg;
+    heat_grid *grid = touch->grid;
+    size_t from = firstRow(grid->n, thread, touch->threads);
+    size_t to = firstRow(grid->n, thread + 1, touch->threads);
+    memset(GRID_ROW(grid, from), 0, (to - from) * grid->stride * sizeof(double));
+}
+
+/**
+ * Allocate a grid of zeros whose rows are first touched by the threads of a pool which sweep
+ * them
+ * @param pool the pool (its threads pinned)
+ * @param threads number of threads of the pool
+ * @param n height
+ * @param m width
+ * @return the grid, or NULL if it could not be allocated
+ */
+heat_grid *touchGrid(thread_pool *pool, unsigned int threads, size_t n, size_t m)
+{
+    touch_run touch = {reserveGrid(n, m), threads};
+    if (touch.grid != NULL)
+    {
+        runPool(pool, touchRows, &touch);
+    }
+    return touch.grid;
+}
+
+/**
+ * Allocate a grid of zeros for calculateGrid with the options. If numa is set and the scheme
+ * runs on threads, every thread first touches the rows it sweeps, so they are on its node.
+ * @param n height
+ * @param m width
+ * @param options the options
+ * @return the grid, or NULL if it could not be allocated
+ */
+heat_grid *allocSolverGrid(size_t n, size_t m, const calc_options *options)
+{
+    unsigned int threads = options->scheme == SCHEME_JACOBI || options->scheme == SCHEME_RED_BLACK
+                           ? options->threads : 1;
+    // As many threads as allocRun, so they touch the rows they sweep
+    threads = n > 0 && threads > n ? (unsigned int) n : threads;
+    if (!options->numa || threads <= 1)
+    {
+        return allocGrid(n, m);
+    }
+    numa_layout *layout = readNumaLayout();
+    thread_pool *pool = layout != NULL ? createPool(threads) : NULL;
+    heat_grid *grid;
+    if (pool == NULL)
+    {
+        grid = allocGrid(n, m);
     }
     else
     {
-        return 0;
+        pinPool(pool, layout);
+        grid = touchGrid(pool, threads, n, m);
+        unpinThread(layout);
+    }
+    freePool(pool);
+    freeNumaLayout(layout);
+    return grid;
+}
+
+/**
+ * Copy the latest values of a calculation in a lower precision to the grid, except the
+ * sources, which keep their exact values
+ * @param run the calculation
+ */
+void widenRun(calc_run *run)
+{
+    const float_grid *floats = run->floats[run->current];
+    heat_grid *grid = run->grids[0];
+    for (size_t i = 0; i < grid->n; i++)
+    {
+        const float *row = GRID_ROW(floats, i);
+        double *out = GRID_ROW(grid, i);
+        size_t k = run->index->rowStart[i];
+        for (size_t j = 0; j < grid->m; j++)
+        {
+            if (k < run->index->rowStart[i + 1] && run->index->cols[k] == j)
+            {
+                k++;
+                continue;
+            }
+            out[j] = row[j];
+        }
+    }
+}
+
+/**
+ * Save the latest values of the grid if the calculation goes on and an interval of
+ * checkpoint_every iterations ended since the previous iteration saved (or checked)
+ * @param run the calculation
+ * @param previous the number of iterations done at the previous check
+ */
+void saveCheckpoint(calc_run *run, double previous)
+{
+    if (run->checkpoint == NULL || run->checkpoint_every == 0 || run->stop
+        || floor(run->iteration / run->checkpoint_every)
+           == floor(previous / run->checkpoint_every))
+    {
+        return;
+    }
+    const heat_grid *latest = run->grids[run->current];
+    if (run->floats[0] != NULL)
+    {
+        widenRun(run);
+        latest = run->grids[0];
+    }
+    if (!run->checkpoint(run->checkpoint_arg, latest, (unsigned int) run->iteration))
+    {
+        run->failed = TRUE;
+        run->stop = TRUE;
+    }
+}
+
+/**
+ * End an iteration (on one thread): add the changes in thread order, so the diff does not
+ * depend on the timing of the threads, and check the stop conditions
+ * @param run the calculation
+ */
+void endIteration(calc_run *run)
+{
+    residual change = run->partial[0];
+    for (unsigned int t = 1; t < poolSize(run->pool); t++)
+    {
+        mergeChange(&change, &run->partial[t]);
+    }
+    if (run->scheme == SCHEME_JACOBI)
+    {
+        run->current = 1 - run->current;
+    }
+    if (run->active != NULL)
+    {
+        endActiveSweep(run->active);
+    }
+    checkIteration(run, &change);
+    profileSweeps(run, 1);
+    saveCheckpoint(run, run->iteration - 1);
+}
+
+/**
+ * Run the calculation on one thread, with a barrier around the end of every iteration
+ * @param arg the calculation
+ * @param thread the thread
+ */
+void calculateTask(void *arg, unsigned int thread)
+{
+    calc_run *run = (calc_run *) arg;
+    while (TRUE)
+    {
+        sweepRows(run, thread);
+        poolBarrier(run->pool);
+        if (thread == 0)
+        {
+            endIteration(run);
+        }
+        poolBarrier(run->pool);
+        if (run->stop)
+        {
+            return;
+        }
     }
+}
 
+/**
+ * Run the calculation on the calling thread, tile iterations at a time as a wavefront.
+ * The stop conditions are checked after every iteration of a band. If the calculation stops
+ * before the end of a band, the band runs again from a copy of the grid up to that iteration.
+ * @param run the calculation (without cyclic borders)
+ * @param tile number of iterations of a band
+ * @return 1 iff the working memory could be allocated
+ */
+int calculateTiled(calc_run *run, size_t tile)
+{
+    int jacobi = run->scheme == SCHEME_JACOBI;
+    size_t bytes = run->grids[0]->n * run->grids[0]->stride * sizeof(double);
+    int norms = run->norm != NORM_SUM;
+    if (tile > SIZE_MAX / sizeof(residual))
+    {
+        return FALSE;
+    }
+    residual *changes = (residual *) malloc(sizeof(residual) * tile);
+    // Without a threshold (terminate 0) nor a cancel flag the calculation never stops inside a
+    // band
+    int stops = run->terminate > 0 || run->cancel != NULL;
+    heat_grid *copy = stops ? allocGrid(run->grids[0]->n, run->grids[0]->m) : NULL;
+    if (changes == NULL || (stops && copy == NULL))
+    {
+        free(changes);
+        freeGrid(copy);
+        return FALSE;
+    }
+    while (!run->stop)
+    {
+        double previous = run->iteration;
+        size_t count = tile;
+        // At least one iteration, like the other calculations (even when resumed past n_iter)
+        if (run->last - run->iteration < (double) count)
+        {
+            count = run->last > run->iteration ? (size_t) (run->last - run->iteration) : 1;
+        }
+        heat_grid *grids[2] = {run->grids[run->current], run->grids[1 - run->current]};
+        if (copy != NULL)
+        {
+            memcpy(copy->data, grids[0]->data, bytes);
+        }
+        sweepWavefront(run->function, run->interior, grids, jacobi, run->index, count, norms,
+                       changes);
+        size_t done = 0;
+        while (done < count && !run->stop)
+        {
+            checkIteration(run, &changes[done++]);
+        }
+        if (done < count)
+        {
+            memcpy(grids[0]->data, copy->data, bytes);
+            sweepWavefront(run->function, run->interior, grids, jacobi, run->index, done, norms,
+                           changes);
+        }
+        profileSweeps(run, done);
+        if (jacobi && done % 2 == 1)
+        {
+            run->current = 1 - run->current;
+        }
+        saveCheckpoint(run, previous);
+    }
+    free(changes);
+    freeGrid(copy);
+    return TRUE;
+}
+
+/**
+ * Run the calculation on the calling thread, a multigrid cycle per iteration
+ * @param run the calculation
+ * @return 1 iff the levels could be allocated
+ */
+int calculateMultigrid(calc_run *run)
+{
+    multigrid *solver = createMultigrid(run->grids[0], run->index, run->is_cyclic);
+    if (solver == NULL)
+    {
+        return FALSE;
+    }
+    while (!run->stop)
+    {
+        residual change;
+        clearChange(&change, needsNorms(run, run->iteration + 1));
+        cycleMultigrid(run->function, run->interior, run->grids[0], solver, run->index,
+                       run->is_cyclic, &change);
+        checkIteration(run, &change);
+        profileSweeps(run, 1);
+        saveCheckpoint(run, run->iteration - 1);
+    }
+    freeMultigrid(solver);
+    return TRUE;
+}
+
+/**
+ * Build the index of the sources of a block of rows
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param first first row of the block
+ * @param block the block: a halo row, its rows, a halo row
+ * @return the index, or NULL if the allocation failed
+ */
+source_index *indexBlock(const source_point *sources, size_t num_sources, size_t first,
+                         const heat_grid *block)
+{
+    source_point *shifted = (source_point *) malloc(sizeof(source_point) * (num_sources + 1));
+    if (shifted == NULL)
+    {
+        return NULL;
+    }
+    size_t count = 0;
+    for (size_t k = 0; k < num_sources; k++)
+    {
+        // The sources of the halo rows are not needed, the halo rows are not updated
+        if ((size_t) sources[k].x >= first && (size_t) sources[k].x - first + 2 < block->n)
+        {
+            shifted[count] = sources[k];
+            shifted[count++].x = (int) ((size_t) sources[k].x - first + 1);
+        }
+    }
+    source_index *index = buildSourceIndex(shifted, count, block->n, block->m);
+    free(shifted);
+    return index;
 }
 
 /**
- * Get the bottom neighbor
+ * Free the blocks of the processes of a distributed calculation
+ * @param blocks the two blocks of every process, one after the other (may be NULL)
+ * @param indexes the source index of every process (may be NULL)
+ * @param processes number of processes
+ */
+void freeBlocks(heat_grid **blocks, source_index **indexes, unsigned int processes)
+{
+    for (unsigned int rank = 0; rank < processes; rank++)
+    {
+        if (blocks != NULL)
+        {
+            freeGrid(blocks[2 * rank]);
+            freeGrid(blocks[2 * rank + 1]);
+        }
+        if (indexes != NULL)
+        {
+            freeSourceIndex(indexes[rank]);
+        }
+    }
+    free(blocks);
+    free(indexes);
+}
+
+/**
+ * Allocate the blocks of the processes of a distributed calculation without writing their
+ * cells (every process first touches its own ones), and the index of their sources
+ * @param sources sources list
+ * @param num_sources size of the list
  * @param grid the grid
- * @param m width of the grid
- * @param is_cyclic tell how to deal with borders
- * @param i i coord
- * @param j j coord
- * @return value of the neighbor
+ * @param processes number of processes
+ * @param blocks set to the two blocks of every process, one after the other
+ * @param indexes set to the source index of every process
+ * @return 1 iff they could be allocated (else they are freed)
  */
-double getDown(double **grid, size_t n, int is_cyclic, int i, int j)
+int allocBlocks(const source_point *sources, size_t num_sources, const heat_grid *grid,
+                unsigned int processes, heat_grid ***blocks, source_index ***indexes)
 {
-    if (is_cyclic >= TRUE || i + 1 < (int)n)
+    *blocks = (heat_grid **) calloc(2 * (size_t) processes, sizeof(heat_grid *));
+    *indexes = (source_index **) calloc(processes, sizeof(source_index *));
+    int ready = *blocks != NULL && *indexes != NULL;
+    for (unsigned int rank = 0; ready && rank < processes; rank++)
     {
-        return grid[(i + 1) % n][j];
+        size_t first = firstRow(grid->n, rank, processes);
+        size_t height = firstRow(grid->n, rank + 1, processes) - first + 2;
+        heat_grid **pair = *blocks + 2 * rank;
+        pair[0] = reserveGrid(height, grid->m);
+        pair[1] = reserveGrid(height, grid->m);
+        if (pair[0] != NULL && pair[1] != NULL)
+        {
+            (*indexes)[rank] = indexBlock(sources, num_sources, first, pair[0]);
+        }
+        ready = (*indexes)[rank] != NULL;
     }
-    else
+    if (!ready)
     {
-        return 0;
+        freeBlocks(*blocks, *indexes, processes);
     }
+    return ready;
+}
 
+/**
+ * Run a Jacobi calculation on processes which share the rows (see distributed.h). Every
+ * process sweeps its block on one thread and finds the same diff, but only the calling process
+ * returns from here: the others exit. The blocks of all the processes are allocated before they
+ * are forked, so the forked processes allocate nothing (a lock of the allocator may be held by
+ * another thread of the calling process when it forks).
+ * @param run the calculation
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param processes number of processes, including the calling one
+ * @param layout the processors to pin the processes to, NULL for none
+ * @param iterations set to the number of iterations run
+ * @return the last difference, or -1 if the blocks could not be allocated or a process could
+ * not be started
+ */
+double distributeGrid(calc_run *run, const source_point *sources, size_t num_sources,
+                      unsigned int processes, const numa_layout *layout,
+                      unsigned long *iterations)
+{
+    heat_grid *grid = run->grids[0];
+    size_t n = grid->n;
+    processes = n == 0 ? 1 : processes < n ? processes : (unsigned int) n;
+    heat_profile *profile = run->profile;
+    double start = run->iteration;
+    // The calling process reads the flag, and tells the others with the changes
+    cancel_flag *cancel = run->cancel;
+    run->cancel = NULL;
+    heat_grid **all;
+    source_index **indexes;
+    if (!allocBlocks(sources, num_sources, grid, processes, &all, &indexes))
+    {
+        return -1;
+    }
+    cluster *group = createCluster(processes, n, grid->m);
+    if (group == NULL)
+    {
+        freeBlocks(all, indexes, processes);
+        return -1;
+    }
+    unsigned int rank = clusterRank(group);
+    if (rank > 0)
+    {
+        run->progress = NULL;
+    }
+    if (layout != NULL)
+    {
+        pinThread(layout, rank, processes);
+    }
+    size_t first = firstRow(n, rank, processes), last = firstRow(n, rank + 1, processes);
+    heat_grid **blocks = all + 2 * rank;
+    source_index *index = indexes[rank];
+    // Every process first touches its own blocks
+    for (int k = 0; k < 2; k++)
+    {
+        memset(blocks[k]->data, 0, blocks[k]->n * blocks[k]->stride * sizeof(double));
+    }
+    for (size_t i = first; i < last; i++)
+    {
+        memcpy(GRID_ROW(blocks[0], i - first + 1), GRID_ROW(grid, i), grid->m * sizeof(double));
+    }
+    int ready = syncCluster(group, TRUE);
+    // The processes sweep the same iterations, the calling one times them
+    startProfile(run, rank == 0 ? profile : NULL, (double) n * (double) grid->m,
+                 HEAT_CELL_FLOPS + CHANGE_CELL_FLOPS, 3 * sizeof(double));
+    startProgress(run, (double) n * (double) grid->m);
+    while (ready && !run->stop)
+    {
+        heat_grid *src = blocks[run->current], *dst = blocks[1 - run->current];
+        exchangeHalos(group, src, run->is_cyclic);
+        residual change, total;
+        clearChange(&change, needsNorms(run, run->iteration + 1));
+        updateRows(run->function, run->interior, dst, src, index, run->is_cyclic, 1,
+                   dst->n - 1, &change);
+        run->current = 1 - run->current;
+        int cancelled = reduceChanges(group, &change, &total,
+                                      rank == 0 && cancel != NULL && isCancelled(cancel));
+        checkIteration(run, &total);
+        if (cancelled && !run->stop)
+        {
+            run->stop = TRUE;
+            run->cancelled = TRUE;
+        }
+        profileSweeps(run, 1);
+    }
+    int done = leaveCluster(group, ready ? blocks[run->current] : NULL, first, grid);
+    freeBlocks(all, indexes, processes);
+    *iterations = (unsigned long) (run->iteration - start);
+    profileNodes(run, layout, processes, *iterations);
+    return done ? run->diff : -1;
 }
 
 /**
- * Get the up neighbor
+ * Set up a calculation with the options, before its working memory: check the SIMD sweep,
+ * compile the stencil and read the layout of the threads
+ * @param run the calculation, set (to be closed with closeRun even when it fails)
+ * @param function function to apply
  * @param grid the grid
- * @param m width of the grid
  * @param is_cyclic tell how to deal with borders
- * @param i i coord
- * @param j j coord
- * @return value of the neighbor
+ * @param options the options
+ * @return 1 iff the SIMD check passed, the stencil can run the scheme, and the function is
+ * heat_eqn for a multigrid scheme
+ */
+int openRun(calc_run *run, diff_func function, heat_grid *grid, int is_cyclic,
+            const calc_options *options)
+{
+    memset(run, 0, sizeof(calc_run));
+    if (options->check_simd)
+    {
+        double difference = compareSimd(options->simd, grid);
+        if (difference < 0 || difference > SIMD_TOLERANCE)
+        {
+            return FALSE;
+        }
+    }
+    // The stencil of heat_eqn runs its sweeps, the others are compiled for the grid
+    if (options->stencil.count > 0 && isHeatStencil(&options->stencil))
+    {
+        function = heat_eqn;
+    }
+    else if (options->stencil.count > 0)
+    {
+        if (options->scheme != SCHEME_GAUSS_SEIDEL && options->scheme != SCHEME_JACOBI)
+        {
+            return FALSE;
+        }
+        run->stencil = compileStencil(&options->stencil, grid);
+        if (run->stencil == NULL)
+        {
+            return FALSE;
+        }
+    }
+    // The coarse corrections of a multigrid cycle apply the operator of heat_eqn
+    if (options->scheme == SCHEME_MULTIGRID && function != heat_eqn)
+    {
+        return FALSE;
+    }
+    run->function = function;
+    run->interior = getHeatInterior(options->simd);
+    run->interior32 = getHeatInterior32(options->simd);
+    run->scheme = options->scheme;
+    run->grids[0] = grid;
+    run->is_cyclic = is_cyclic;
+    run->last = INFINITY;
+    run->norm = options->norm;
+    run->check_every = options->check_every;
+    run->checkpoint = options->checkpoint;
+    run->checkpoint_arg = options->checkpoint_arg;
+    run->checkpoint_every = options->checkpoint_every;
+    run->iteration = options->start_iteration;
+    run->layout = options->numa ? readNumaLayout() : NULL;
+    run->progress = options->progress;
+    run->progress_arg = options->progress_arg;
+    run->progress_every = options->progress_every;
+    run->cancel = options->cancel;
+    return TRUE;
+}
+
+/**
+ * Allocate the working memory of a calculation opened with openRun
+ * @param run the calculation
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param max_sources number of sources the index has room for, at least num_sources
+ * @param options the options of openRun
+ * @return 1 iff it could be allocated
  */
-double getUp(double **grid, size_t n, int is_cyclic, int i, int j)
+int allocRun(calc_run *run, const source_point *sources, size_t num_sources,
+             size_t max_sources, const calc_options *options)
 {
+    heat_grid *grid = run->grids[0];
+    // Temporal blocking needs the previous iteration of the next rows, so no cyclic borders.
+    // A band deeper than the grid keeps no fewer rows in use: at most n iterations a band.
+    size_t tile = options->tile < grid->n ? options->tile : grid->n;
+    run->tile = tile > 1 && run->is_cyclic < TRUE && run->stencil == NULL
+                && (run->scheme == SCHEME_GAUSS_SEIDEL || run->scheme == SCHEME_JACOBI)
+                ? tile : 0;
+    // The in place updates read the cells just updated, they run on the calling thread only
+    run->threads = run->scheme == SCHEME_GAUSS_SEIDEL || run->scheme == SCHEME_MULTIGRID
+                   || run->tile > 0 || options->threads == 0 ? 1 : options->threads;
+    // Every thread gets a row at least: thread 0 owns the first row, which sweepColours needs
+    if (grid->n > 0 && run->threads > grid->n)
+    {
+        run->threads = (unsigned int) grid->n;
+    }
+    int narrow = options->precision != PRECISION_DOUBLE && run->tile == 0 && run->stencil == NULL
+                 && run->scheme != SCHEME_MULTIGRID;
+    run->sum = options->precision == PRECISION_FLOAT ? SUM_FLOAT
+               : options->precision == PRECISION_KAHAN ? SUM_KAHAN : SUM_DOUBLE;
+    // The grids go through the memory once per sweep (once per band of a tiled one)
+    run->cell_flops = (run->stencil != NULL ? 2.0 * (double) options->stencil.count - 1
+                                            : HEAT_CELL_FLOPS) + CHANGE_CELL_FLOPS;
+    run->cell_bytes = (double) (narrow ? sizeof(float) : sizeof(double))
+                      * (run->scheme == SCHEME_JACOBI ? 3 : 2)
+                      / (run->tile > 0 ? run->tile : 1);
+    run->index = reserveSourceIndex(max_sources, grid->n);
+    int ready = run->index != NULL && fillSourceIndex(run->index, sources, num_sources, grid->m);
+    run->partial = (residual *) malloc(sizeof(residual) * run->threads);
+    if (run->threads > 1)
+    {
+        run->pool = createPool(run->threads);
+    }
+    // The pinned threads of the pool first touch the rows of the second grid they sweep
+    run->pinned = run->layout != NULL && run->pool != NULL;
+    if (run->pinned)
+    {
+        pinPool(run->pool, run->layout);
+    }
+    int buffers = run->scheme == SCHEME_JACOBI ? 2 : 1;
+    for (int k = 0; k < buffers; k++)
+    {
+        if (narrow)
+        {
+            run->floats[k] = allocFloatGrid(grid->n, grid->m);
+            ready = ready && run->floats[k] != NULL;
+        }
+        else if (k > 0)
+        {
+            run->grids[k] = run->pinned ? touchGrid(run->pool, run->threads, grid->n, grid->m)
+                                        : allocGrid(grid->n, grid->m);
+            ready = ready && run->grids[k] != NULL;
+        }
+    }
+    if (run->pinned)
+    {
+        unpinThread(run->layout);
+    }
+    if (options->sparse && !narrow && run->tile == 0 && run->stencil == NULL
+        && (run->scheme == SCHEME_GAUSS_SEIDEL || run->scheme == SCHEME_JACOBI))
+    {
+        run->active = createActiveMap(grid->n, grid->m, run->is_cyclic);
+        ready = ready && run->active != NULL;
+    }
+    return ready && run->partial != NULL && (run->threads == 1 || run->pool != NULL);
+}
 
-    if (is_cyclic >= TRUE || i - 1 >= 0)
+/**
+ * Run a calculation allocated with allocRun from the values of its grid, until its stop
+ * conditions, and write the latest values to its grid. Allocates nothing but the working
+ * memory of tiled and multigrid calculations.
+ * @param run the calculation
+ * @param profile the profile, NULL for none
+ * @param iterations set to the number of iterations run
+ * @return the last difference, or -1 if the working memory could not be allocated or a
+ * checkpoint could not be saved
+ */
+double executeRun(calc_run *run, heat_profile *profile, unsigned long *iterations)
+{
+    heat_grid *grid = run->grids[0];
+    double start = run->iteration;
+    run->current = 0;
+    run->stop = FALSE;
+    run->failed = FALSE;
+    run->cancelled = FALSE;
+    if (run->active != NULL)
     {
-        return grid[(i - 1 + n) % n][j];
+        resetActiveMap(run->active);
+    }
+    if (run->pinned)
+    {
+        pinThread(run->layout, 0, run->threads);
+    }
+    if (run->floats[0] != NULL)
+    {
+        narrowGrid(run->floats[0], grid);
+    }
+    startProfile(run, profile, (double) grid->n * (double) grid->m, run->cell_flops,
+                 run->cell_bytes);
+    startProgress(run, (double) grid->n * (double) grid->m);
+    int done = TRUE;
+    if (run->tile > 0)
+    {
+        done = calculateTiled(run, run->tile);
+    }
+    else if (run->scheme == SCHEME_MULTIGRID)
+    {
+        done = calculateMultigrid(run);
     }
     else
     {
-        return 0;
+        runPool(run->pool, calculateTask, run);
+    }
+    if (run->floats[0] != NULL)
+    {
+        widenRun(run);
+    }
+    else if (run->current == 1)
+    {
+        memcpy(grid->data, run->grids[1]->data, grid->n * grid->stride * sizeof(double));
+    }
+    if (run->pinned)
+    {
+        unpinThread(run->layout);
     }
+    *iterations = (unsigned long) (run->iteration - start);
+    profileNodes(run, run->pinned ? run->layout : NULL, run->threads, *iterations);
+    return done && !run->failed ? run->diff : -1;
+}
 
+/**
+ * Free the working memory of a calculation opened with openRun (but not its grid)
+ * @param run the calculation
+ */
+void closeRun(calc_run *run)
+{
+    freePool(run->pool);
+    freeGrid(run->grids[1]);
+    freeFloatGrid(run->floats[0]);
+    freeFloatGrid(run->floats[1]);
+    freeActiveMap(run->active);
+    freeStencilKernel(run->stencil);
+    free(run->partial);
+    freeSourceIndex(run->index);
+    freeNumaLayout(run->layout);
 }
 
 /**
- * One iteration of updating the grid, and calculate diff
+ * Update the grid, and calculate diff (see calculateGrid, the precision is not checked)
  * @param function function to apply
  * @param grid the grid
- * @param n height of the grid
- * @param m width of the grid
  * @param sources sources list
  * @param num_sources size of the list
+ * @param terminate minimum diff to stop
+ * @param n_iter number of iterations to stop
  * @param is_cyclic tell how to deal with borders
- * @return the difference after this iteration
+ * @param options the options
+ * @param iterations set to the number of iterations run
+ * @return the last difference, or -1 if the working memory could not be allocated, the SIMD
+ * check failed, a checkpoint could not be saved, the stencil cannot run the scheme or the scheme
+ * is multigrid with another function than heat_eqn
  */
-double
-calculateIteration(diff_func function, double **grid, size_t n, size_t m, source_point *sources,
-                   size_t num_sources,
-                   int is_cyclic)
+double solveGrid(diff_func function, heat_grid *grid, source_point *sources, size_t num_sources,
+                 double terminate, unsigned int n_iter, int is_cyclic,
+                 const calc_options *options, unsigned long *iterations)
 {
-
-    double sum = 0;
-    for (int i = 0; i < (int)n; i++)
+    *iterations = 0;
+    calc_run run;
+    double diff = -1;
+    if (openRun(&run, function, grid, is_cyclic, options))
     {
-        for (int j = 0; j < (int)m; j++)
+        run.terminate = terminate;
+        run.last = n_iter > 0 ? (double) n_iter + 1 : INFINITY;
+        if (options->processes > 1 && run.scheme == SCHEME_JACOBI && run.stencil == NULL)
         {
-            if (isSource(sources, num_sources, i, j) == FALSE)
+            run.profile = options->profile;
+            diff = distributeGrid(&run, sources, num_sources, options->processes, run.layout,
+                                  iterations);
+            if (run.layout != NULL)
             {
-                grid[i][j] = function(grid[i][j], getRight(grid, m, is_cyclic, i, j),
-                                      getUp(grid, n, is_cyclic, i, j),
-                                      getLeft(grid, m, is_cyclic, i, j),
-                                      getDown(grid, n, is_cyclic, i, j));
+                unpinThread(run.layout);
             }
-
-            sum += grid[i][j];
         }
+        else if (allocRun(&run, sources, num_sources, num_sources, options))
+        {
+            diff = executeRun(&run, options->profile, iterations);
+        }
+    }
+    closeRun(&run);
+    return diff;
+}
+
+/**
+ * Open a session: a calculation whose working memory is allocated once, and which is run
+ * again on its grid with runSession
+ * @param function function to apply
+ * @param grid the grid, kept by the session
+ * @param max_sources number of sources the session has room for
+ * @param is_cyclic tell how to deal with borders
+ * @param options the options (NULL for the defaults)
+ * @return the session, or NULL if the options are not supported by a session, the working
+ * memory could not be allocated, the SIMD check failed or the stencil cannot run the scheme
+ */
+calc_session *openSession(diff_func function, heat_grid *grid, size_t max_sources,
+                          int is_cyclic, const calc_options *options)
+{
+    calc_options defaults;
+    if (options == NULL)
+    {
+        initOptions(&defaults);
+        options = &defaults;
+    }
+    if (options->scheme == SCHEME_MULTIGRID || options->processes > 1)
+    {
+        return NULL;
+    }
+    calc_session *session = (calc_session *) malloc(sizeof(calc_session));
+    if (session == NULL)
+    {
+        return NULL;
+    }
+    session->profile = options->profile;
+    // A tiled calculation allocates its bands when it runs
+    if (!openRun(&session->run, function, grid, is_cyclic, options)
+        || !allocRun(&session->run, NULL, 0, max_sources, options) || session->run.tile > 0)
+    {
+        closeSession(session);
+        return NULL;
+    }
+    return session;
+}
+
+/**
+ * Replace the sources of a session (the values of their cells are not written)
+ * @param session the session
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @return 1 iff they were set, 0 if the session has no room for them
+ */
+int setSessionSources(calc_session *session, const source_point *sources, size_t num_sources)
+{
+    const heat_grid *grid = session->run.grids[0];
+    return fillSourceIndex(session->run.index, sources, num_sources, grid->m);
+}
+
+/**
+ * Run a session from the values of its grid, and write the latest values to it
+ * @param session the session
+ * @param terminate minimum diff to stop
+ * @param max_iterations number of iterations to stop, 0 for none
+ * @param iterations set to the number of iterations run
+ * @return the last difference, or -1 if a checkpoint could not be saved
+ */
+double runSession(calc_session *session, double terminate, unsigned long max_iterations,
+                  unsigned long *iterations)
+{
+    calc_run *run = &session->run;
+    run->terminate = terminate;
+    run->last = max_iterations > 0 ? run->iteration + (double) max_iterations : INFINITY;
+    return executeRun(run, session->profile, iterations);
+}
+
+/**
+ * Tell if the last run of a session was stopped by the cancel flag of its options
+ * @param session the session
+ * @return 1 iff it was cancelled
+ */
+int sessionCancelled(const calc_session *session)
+{
+    return session->run.cancelled;
+}
+
+/**
+ * Get the number of iterations done by a session
+ * @param session the session
+ * @return the iterations, from the start_iteration of its options
+ */
+unsigned long sessionIterations(const calc_session *session)
+{
+    return (unsigned long) session->run.iteration;
+}
+
+/**
+ * Close a session (but not its grid)
+ * @param session the session (may be NULL)
+ */
+void closeSession(calc_session *session)
+{
+    if (session == NULL)
+    {
+        return;
     }
-    return sum;
+    closeRun(&session->run);
+    free(session);
 }
 
 /**
- * A diff function that's just return the value of the cell
- * @param cell cell value
- * @param right not used, but needed for the signature
- * @param top not used, but needed for the signature
- * @param left not used, but needed for the signature
- * @param bottom not used, but needed for the signature
- * @return cell value
+ * Measure the drift of a calculation from the same calculation in double
+ * @param drift the drift, set
+ * @param grid the grid of the calculation
+ * @param reference the grid of the calculation in double
+ * @param diff the diff of the calculation
+ * @param referenceDiff the diff of the calculation in double
  */
-double noEffect(double cell, double right, double top, double left, double bottom)
+void measureDrift(precision_drift *drift, const heat_grid *grid, const heat_grid *reference,
+                  double diff, double referenceDiff)
 {
-    UNUSED(right);
-    UNUSED(top);
-    UNUSED(left);
-    UNUSED(bottom);
-    return cell;
+    drift->cells = 0;
+    for (size_t i = 0; i < grid->n; i++)
+    {
+        const double *row = GRID_ROW(grid, i), *exact = GRID_ROW(reference, i);
+        for (size_t j = 0; j < grid->m; j++)
+        {
+            double distance = fabs(row[j] - exact[j]);
+            drift->cells = distance > drift->cells ? distance : drift->cells;
+        }
+    }
+    drift->diff = fabs(diff - referenceDiff);
 }
 
 /**
  * Update the grid, and calculate diff
  * @param function function to apply
  * @param grid the grid
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param terminate minimum diff to stop
+ * @param n_iter number of iterations to stop
+ * @param is_cyclic tell how to deal with borders
+ * @param options scheme, threads, instruction set, tiling, convergence measure, checkpoints,
+ * precision and stencil, NULL for the defaults
+ * @return the last difference, or -1 if the working memory could not be allocated, the SIMD
+ * check failed, a checkpoint could not be saved, the stencil cannot run the scheme or the scheme
+ * is multigrid with another function than heat_eqn
+ */
+double calculateGrid(diff_func function, heat_grid *grid, source_point *sources,
+                     size_t num_sources, double terminate, unsigned int n_iter, int is_cyclic,
+                     const calc_options *options)
+{
+    calc_options defaults;
+    if (options == NULL)
+    {
+        initOptions(&defaults);
+        options = &defaults;
+    }
+    unsigned long iterations;
+    if (!options->check_precision || options->precision == PRECISION_DOUBLE
+        || options->drift == NULL)
+    {
+        return solveGrid(function, grid, sources, num_sources, terminate, n_iter, is_cyclic,
+                         options, &iterations);
+    }
+    heat_grid *reference = allocGrid(grid->n, grid->m);
+    if (reference == NULL)
+    {
+        return -1;
+    }
+    memcpy(reference->data, grid->data, grid->n * grid->stride * sizeof(double));
+    double diff = solveGrid(function, grid, sources, num_sources, terminate, n_iter, is_cyclic,
+                            options, &iterations);
+    calc_options exact = *options;
+    exact.precision = PRECISION_DOUBLE;
+    exact.checkpoint = NULL;
+    exact.profile = NULL;
+    exact.progress = NULL;
+    unsigned long referenceIterations;
+    double referenceDiff = solveGrid(function, reference, sources, num_sources, terminate,
+                                     n_iter, is_cyclic, &exact, &referenceIterations);
+    if (diff >= 0 && referenceDiff >= 0)
+    {
+        measureDrift(options->drift, grid, reference, diff, referenceDiff);
+        options->drift->iterations = iterations;
+        options->drift->reference_iterations = referenceIterations;
+    }
+    else
+    {
+        diff = -1;
+    }
+    freeGrid(reference);
+    return diff;
+}
+
+/**
+ * Update a grid in a file in place, a band of rows at a time, and calculate diff
+ * @param function function to apply
+ * @param grid the grid
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param terminate minimum diff to stop
+ * @param n_iter number of iterations to stop
+ * @param is_cyclic tell how to deal with borders
+ * @param options convergence measure, start iteration, band and profile, NULL for the defaults
+ * @return the last difference, or -1 if the working memory could not be allocated or the file
+ * could not be read or written
+ */
+double calculateDisk(diff_func function, disk_grid *grid, source_point *sources,
+                     size_t num_sources, double terminate, unsigned int n_iter, int is_cyclic,
+                     const calc_options *options)
+{
+    calc_options defaults;
+    if (options == NULL)
+    {
+        initOptions(&defaults);
+        options = &defaults;
+    }
+    calc_run run;
+    memset(&run, 0, sizeof(run));
+    run.terminate = terminate;
+    run.last = n_iter > 0 ? (double) n_iter + 1 : INFINITY;
+    run.norm = options->norm;
+    run.check_every = options->check_every;
+    run.iteration = options->start_iteration;
+    run.progress = options->progress;
+    run.progress_arg = options->progress_arg;
+    run.progress_every = options->progress_every;
+    run.cancel = options->cancel;
+    source_index *index = buildSourceIndex(sources, num_sources, grid->n, grid->m);
+    disk_sweep *sweep = createDiskSweep(grid, options->band > 0 ? options->band : DISK_BAND);
+    double diff = -1;
+    if (index != NULL && sweep != NULL)
+    {
+        int moved = TRUE;
+        startProfile(&run, options->profile, (double) grid->n * (double) grid->m,
+                     HEAT_CELL_FLOPS + CHANGE_CELL_FLOPS, 2 * sizeof(double));
+        startProgress(&run, (double) grid->n * (double) grid->m);
+        while (!run.stop && moved)
+        {
+            residual change;
+            clearChange(&change, needsNorms(&run, run.iteration + 1));
+            moved = sweepDisk(function, grid, sweep, index, is_cyclic, &change);
+            checkIteration(&run, &change);
+            profileSweeps(&run, 1);
+        }
+        diff = moved ? run.diff : -1;
+    }
+    freeDiskSweep(sweep);
+    freeSourceIndex(index);
+    return diff;
+}
+
+/**
+ * Update the grid, and calculate diff (array of rows version, see calculateGrid)
+ * @param function function to apply
+ * @param grid the grid
  * @param n height of the grid
  * @param m width of the grid
  * @param sources sources list
@@ -191,24 +1366,20 @@ double noEffect(double cell, double right, double top, double left, double botto
  * @param terminate minimum diff to stop
  * @param n_iter number of iterations to stop
  * @param is_cyclic tell how to deal with borders
- * @return the last difference
+ * @return the last difference, or -1 if the working memory could not be allocated
  */
 double calculate(diff_func function, double **grid, size_t n, size_t m, source_point *sources,
                  size_t num_sources, double terminate, unsigned int n_iter, int is_cyclic)
 {
-    double prevSum, sum, diff = 0, i = 0;
-    prevSum = calculateIteration(noEffect, grid, n, m, sources, num_sources, is_cyclic);
-    while (TRUE)
+    heat_grid *work = allocGrid(n, m);
+    if (work == NULL)
     {
-        sum = calculateIteration(function, grid, n, m, sources, num_sources, is_cyclic);
-        diff = fabs(sum - prevSum);
-        i++;
-        if ((n_iter > 0 && i > n_iter) || diff < terminate)
-        {
-            return diff;
-        }
-        prevSum = sum;
-
+        return -1;
     }
-
+    loadRows(work, grid);
+    double diff = calculateGrid(function, work, sources, num_sources, terminate, n_iter,
+                                is_cyclic, NULL);
+    storeRows(work, grid);
+    freeGrid(work);
+    return diff;
 }
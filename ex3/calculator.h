@@ -8,6 +8,9 @@
 #define CALCULATOR_H
 
 #include <stdlib.h>
+#include "grid.h"
+#include "profile.h"
+#include "simd.h"
 
 /**
  * Structure to hold heat sources.
@@ -23,8 +26,266 @@ typedef struct
  */
 typedef double (*diff_func)(double cell, double right, double top, double left, double bottom);
 
+/**
+ * Maximum number of points of a stencil.
+ */
+#define STENCIL_MAX_POINTS 25
+
+/**
+ * A point of a stencil: the new value of the cell (i, j) adds weight times the cell
+ * (i + di, j + dj).
+ */
+typedef struct
+{
+	int di, dj;
+	double weight;
+} stencil_point;
+
+/**
+ * A linear update of the cells: the new value of a cell is the weighted sum of the cells at
+ * the offsets of the points (see stencil.h). No points (count 0) for none.
+ */
+typedef struct
+{
+	size_t count;
+	stencil_point points[STENCIL_MAX_POINTS];
+} stencil;
+
+/**
+ * Order in which the cells are updated.
+ * SCHEME_GAUSS_SEIDEL updates the grid in place row by row, every cell sees the cells updated
+ * before it. SCHEME_JACOBI computes every cell from the previous iteration (double buffered),
+ * so the rows can be split between threads. SCHEME_RED_BLACK updates the grid in place in two
+ * phases, first the cells where i + j is even then the others: every cell of a phase only
+ * reads cells of the other colour, so a phase can be split between threads too.
+ * SCHEME_MULTIGRID runs multigrid cycles (see multigrid.h) on the calling thread, an iteration is a
+ * cycle. It needs far fewer iterations than the others to reach a steady state, but the
+ * function must be heat_eqn.
+ */
+typedef enum
+{
+	SCHEME_GAUSS_SEIDEL,
+	SCHEME_JACOBI,
+	SCHEME_RED_BLACK,
+	SCHEME_MULTIGRID
+} update_scheme;
+
+/**
+ * Measure of the change of the grid in an iteration, compared with terminate.
+ * NORM_SUM is the difference of the sums of the grid before and after the iteration, the
+ * others are the L1, L2 and maximum norms of the changes of the cells.
+ */
+typedef enum
+{
+	NORM_SUM,
+	NORM_L1,
+	NORM_L2,
+	NORM_LINF
+} convergence_norm;
+
+/**
+ * Precision of the cells during the calculation (the grid itself stays in double).
+ * PRECISION_FLOAT sweeps a float copy of the grid and adds the changes up in float,
+ * PRECISION_MIXED sweeps floats but adds the changes up in double, and PRECISION_KAHAN adds
+ * them up in float with a compensated (Kahan) sum. A float sweep moves half the bytes of a
+ * double one and fits twice as many cells in a SIMD register.
+ */
+typedef enum
+{
+	PRECISION_DOUBLE,
+	PRECISION_FLOAT,
+	PRECISION_MIXED,
+	PRECISION_KAHAN
+} precision_mode;
+
+/**
+ * Drift of a calculation in a lower precision from the same calculation in double: the
+ * biggest difference of a cell, the difference of the diffs, and the number of iterations of
+ * both.
+ */
+typedef struct
+{
+	double cells, diff;
+	unsigned long iterations, reference_iterations;
+} precision_drift;
+
+/**
+ * Called between two iterations with the latest values of the grid, to save them.
+ * iteration is the number of iterations done by the calculation so far.
+ * Returns 1 iff the grid could be saved.
+ */
+typedef int (*checkpoint_func)(void *arg, const heat_grid *grid, unsigned int iteration);
+
+/**
+ * Called between two iterations with the progress of a calculation: iteration is the number of
+ * iterations done so far, diff the last diff measured, and cells_per_second the cells updated
+ * per second since the previous call (or the start of the calculation).
+ */
+typedef void (*progress_func)(void *arg, unsigned long iteration, double diff,
+                              double cells_per_second);
+
+/**
+ * A flag which stops a calculation (see parallel.h).
+ */
+struct cancel_flag;
+
+/**
+ * Options of the calculator.
+ * threads is the number of threads sharing the rows (only used by the parallel schemes).
+ * simd is the instruction set of the inner cells of a Jacobi sweep of heat_eqn. If check_simd
+ * is set, that sweep is first compared with the scalar one on the grid (within SIMD_TOLERANCE).
+ * tile is the number of iterations run together as a wavefront over the rows (temporal
+ * blocking, on the calling thread), 0 or 1 for none. Only for the Gauss-Seidel and Jacobi
+ * schemes without cyclic borders, the other calculations ignore it.
+ * norm is the measure of the change compared with terminate, and it is only compared every
+ * check_every iterations (0 or 1 for every iteration).
+ * start_iteration is the number of iterations already done, to resume a calculation. If
+ * checkpoint is set, it is called every checkpoint_every iterations (with checkpoint_arg),
+ * except when the calculation stops there. Tiled calculations call it at the end of the first
+ * band past every interval.
+ * band is the number of rows of a band of an out of core calculation (calculateDisk).
+ * precision is the precision of the cells, for the calculations which are neither tiled nor
+ * multigrid (the others run in double). If check_precision is set and drift is not NULL, the
+ * calculation is run again in double on a copy of the grid, and *drift is set.
+ * If sparse is set, the Gauss-Seidel and Jacobi calculations in double which are not tiled
+ * skip the blocks of cells which would not change (see active.h).
+ * If stencil has points, it is the update of the cells instead of the function. The stencil of
+ * heat_eqn (heatStencil) runs like heat_eqn; the others only run the Gauss-Seidel and Jacobi
+ * schemes (in double, without tiling nor sparse blocks).
+ * If profile is not NULL, the sweeps of the calculation are added to it, with every cell of the
+ * grid updated once per sweep (even the blocks a sparse sweep skips), and a multigrid cycle
+ * counted as one sweep. Without it, no clock is read.
+ * processes is the number of processes sharing the rows of a Jacobi calculation of the function
+ * (see distributed.h), 0 or 1 for none. They run in double on one thread each, without tiling,
+ * sparse blocks nor checkpoints, and give the same grid and diff as that many threads.
+ * If numa is set, the threads of the Jacobi and red-black calculations (and the processes) are
+ * pinned to the processors of the process node after node (see numa.h), and the second grid of
+ * a Jacobi calculation in double is first touched by the thread which sweeps its rows. The
+ * profile then holds the bytes moved on every node.
+ * If progress is set, it is called (with progress_arg) on the calling thread every
+ * progress_every iterations (0 or 1 for every iteration), at the end of the band of a tiled
+ * calculation. It must not change the grid.
+ * If cancel is not NULL, the calculation stops after the iteration in which the flag is seen
+ * raised (by the calling process of a distributed one, after the sweeps of the band of a tiled
+ * one), with the grid of that iteration, as if it had reached its last iteration.
+ */
+typedef struct
+{
+	update_scheme scheme;
+	unsigned int threads;
+	simd_level simd;
+	int check_simd;
+	size_t tile;
+	convergence_norm norm;
+	unsigned int check_every;
+	unsigned int start_iteration;
+	checkpoint_func checkpoint;
+	void *checkpoint_arg;
+	unsigned int checkpoint_every;
+	size_t band;
+	precision_mode precision;
+	int check_precision;
+	precision_drift *drift;
+	int sparse;
+	stencil stencil;
+	heat_profile *profile;
+	unsigned int processes;
+	int numa;
+	progress_func progress;
+	void *progress_arg;
+	unsigned int progress_every;
+	struct cancel_flag *cancel;
+} calc_options;
+
+/**
+ * A grid in a file (see outofcore.h).
+ */
+struct disk_grid;
+
+/**
+ * A calculation on a grid whose working memory (the source index, the other grid of a Jacobi
+ * calculation, the threads...) is allocated once, for many runs: a run allocates nothing.
+ */
+typedef struct calc_session calc_session;
+
+/**
+ * Set the default options: in place update on the calling thread.
+ */
+void initOptions(calc_options * options);
+
+/**
+ * Allocate a grid of zeros for calculateGrid with the options. If numa is set and the scheme
+ * runs on threads, every thread first touches the rows it sweeps, so they are on its node.
+ * Returns NULL if it could not be allocated.
+ */
+heat_grid *allocSolverGrid(size_t n, size_t m, const calc_options * options);
+
+/**
+ * Calculator function on a contiguous grid. Applies the given function to every point in the grid iteratively for n_iter loops, or until the cumulative difference is below terminate (if n_iter is 0).
+ * The options (NULL for the defaults) choose the update scheme, the threads and the measure of
+ * the change. The changes of the threads are added in a fixed order, so the result does not
+ * change from run to run.
+ * Returns -1 if the working memory could not be allocated, if the SIMD check failed, if a
+ * checkpoint could not be saved, if the stencil cannot run the scheme, or if the scheme is
+ * multigrid and the function is not heat_eqn.
+ */
+double calculateGrid(diff_func function, heat_grid * grid, source_point * sources, size_t num_sources, double terminate, unsigned int n_iter, int is_cyclic, const calc_options * options);
+
+/**
+ * Open a session: a calculation on a grid, run with runSession. The session has no sources
+ * until setSessionSources. The options are those of calculateGrid, without tiling, multigrid,
+ * processes nor the precision check; start_iteration is the iteration of the session before
+ * its first run, and the checkpoints and the profile go on across the runs.
+ * Returns NULL if the options are not supported by a session, if the working memory could not
+ * be allocated, if the SIMD check failed, or if the stencil cannot run the scheme.
+ */
+calc_session *openSession(diff_func function, heat_grid * grid, size_t max_sources, int is_cyclic, const calc_options * options);
+
+/**
+ * Replace the sources of a session, without allocating. The values of their cells are not
+ * written: the cells of the grid keep their values.
+ * Returns 0 if there are more than the max_sources of the session (the sources are unchanged).
+ */
+int setSessionSources(calc_session * session, const source_point * sources, size_t num_sources);
+
+/**
+ * Run a session from the latest values of its grid, which may have been written since the
+ * previous run, until the diff is below terminate or max_iterations (0 for no limit) are run,
+ * and write the latest values to the grid. A sparse session updates every block in the first
+ * sweep of a run.
+ * Sets *iterations to the number of iterations run, and returns the last difference, or -1 if
+ * a checkpoint could not be saved.
+ */
+double runSession(calc_session * session, double terminate, unsigned long max_iterations, unsigned long * iterations);
+
+/**
+ * Tell if the last run of a session was stopped by the cancel flag of its options.
+ */
+int sessionCancelled(const calc_session * session);
+
+/**
+ * Get the number of iterations done by a session, from its start_iteration.
+ */
+unsigned long sessionIterations(const calc_session * session);
+
+/**
+ * Close a session (the grid stays with the caller). NULL is ignored.
+ */
+void closeSession(calc_session * session);
+
+/**
+ * Calculator function on a grid in a file (see outofcore.h), updated in place a band of rows at
+ * a time like the Gauss-Seidel scheme. Gives the same grid and diff as calculateGrid with that
+ * scheme. Of the options, only the convergence measure, start_iteration, band, profile,
+ * progress and cancel are used.
+ * Returns -1 if the working memory could not be allocated, or if the file could not be read or
+ * written.
+ */
+double calculateDisk(diff_func function, struct disk_grid * grid, source_point * sources, size_t num_sources, double terminate, unsigned int n_iter, int is_cyclic, const calc_options * options);
+
 /**
  * Calculator function. Applies the given function to every point in the grid iteratively for n_iter loops, or until the cumulative difference is below terminate (if n_iter is 0).
+ * Copies the rows into a contiguous grid and back around calculateGrid. Returns -1 if the working memory could not be allocated.
  */
 double calculate(diff_func function, double ** grid, size_t n, size_t m, source_point * sources, size_t num_sources, double terminate, unsigned int n_iter, int is_cyclic);
 
@@ -0,0 +1,191 @@
+/**
+ * @file checkpoint.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Write snapshot files, and map them back.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checkpoint.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define MAGIC_LENGTH 8
+#define TEMPORARY_SUFFIX ".tmp"
+/**
+ * Offset of the grid in the file: a page, so the mapped rows are aligned like allocGrid ones.
+ */
+#define SNAPSHOT_ALIGNMENT 4096
+#define CELLS_PER_LINE (GRID_ALIGNMENT / sizeof(double))
+// ------------------------------ structs -----------------------------
+
+/**
+ * Header of a snapshot file. The offsets and the size are in bytes from the start of the file.
+ */
+typedef struct
+{
+    char magic[MAGIC_LENGTH];
+    uint32_t version, paramsSize;
+    uint64_t n, m, stride, numSources;
+    uint64_t gridOffset, sourcesOffset, size;
+    snapshot_params params;
+} snapshot_header;
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Write a snapshot next to path then rename it (see checkpoint.h)
+ * @param path the file
+ * @param grid the grid
+ * @param sources the sources
+ * @param num_sources number of sources
+ * @param params the parameters of the calculation
+ * @return 1 iff the snapshot was written
+ */
+int writeSnapshot(const char *path, const heat_grid *grid, const source_point *sources,
+                  size_t num_sources, const snapshot_params *params)
+{
+    static const char padding[SNAPSHOT_ALIGNMENT];
+    char temporary[SNAPSHOT_PATH_LENGTH + sizeof(TEMPORARY_SUFFIX)];
+    if (strlen(path) >= SNAPSHOT_PATH_LENGTH)
+    {
+        return FALSE;
+    }
+    sprintf(temporary, "%s%s", path, TEMPORARY_SUFFIX);
+    snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, MAGIC_LENGTH);
+    header.version = SNAPSHOT_VERSION;
+    header.paramsSize = sizeof(snapshot_params);
+    header.n = grid->n;
+    header.m = grid->m;
+    header.stride = grid->stride;
+    header.numSources = num_sources;
+    header.gridOffset = SNAPSHOT_ALIGNMENT;
+    size_t gridBytes = grid->n * grid->stride * sizeof(double);
+    header.sourcesOffset = header.gridOffset + gridBytes;
+    header.size = header.sourcesOffset + num_sources * sizeof(source_point);
+    header.params = *params;
+    header.params.options.checkpoint = NULL;
+    header.params.options.checkpoint_arg = NULL;
+    header.params.options.drift = NULL;
+    header.params.options.profile = NULL;
+    header.params.options.progress = NULL;
+    header.params.options.progress_arg = NULL;
+    header.params.options.cancel = NULL;
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL)
+    {
+        return FALSE;
+    }
+    int written = fwrite(&header, sizeof(header), 1, file) == 1
+                  && fwrite(padding, SNAPSHOT_ALIGNMENT - sizeof(header), 1, file) == 1
+                  && (gridBytes == 0 || fwrite(grid->data, gridBytes, 1, file) == 1)
+                  && (num_sources == 0
+                      || fwrite(sources, sizeof(source_point) * num_sources, 1, file) == 1);
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporary, path) != 0)
+    {
+        remove(temporary);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Check the header of a snapshot file
+ * @param header the header
+ * @param size size of the file
+ * @return 1 iff the header is valid and matches the size
+ */
+int isValidHeader(const snapshot_header *header, size_t size)
+{
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, MAGIC_LENGTH) != 0
+        || header->version != SNAPSHOT_VERSION || header->paramsSize != sizeof(snapshot_params)
+        || header->size != size || header->stride < header->m
+        || header->stride % CELLS_PER_LINE != 0 || header->gridOffset % SNAPSHOT_ALIGNMENT != 0
+        || header->gridOffset < sizeof(snapshot_header))
+    {
+        return FALSE;
+    }
+    // The sizes are checked one at a time, so that none of them overflows
+    uint64_t limit = size / sizeof(double);
+    return header->n <= limit && (header->n == 0 || header->stride <= limit / header->n)
+           && header->sourcesOffset == header->gridOffset
+                                       + header->n * header->stride * sizeof(double)
+           && header->numSources <= size / sizeof(source_point)
+           && header->sourcesOffset + header->numSources * sizeof(source_point) == size;
+}
+
+/**
+ * Map a snapshot
+ * @param path the file
+ * @return the snapshot, or NULL if it could not be mapped or is not a valid snapshot
+ */
+heat_snapshot *openSnapshot(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    struct stat status;
+    heat_snapshot *snapshot = NULL;
+    if (fstat(fd, &status) == 0 && (size_t) status.st_size >= sizeof(snapshot_header))
+    {
+        snapshot = (heat_snapshot *) malloc(sizeof(heat_snapshot));
+    }
+    if (snapshot != NULL)
+    {
+        snapshot->size = (size_t) status.st_size;
+        // Private and writable: the calculation updates the grid in place, not the file
+        snapshot->mapping = mmap(NULL, snapshot->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                                 0);
+    }
+    close(fd);
+    if (snapshot == NULL || snapshot->mapping == MAP_FAILED)
+    {
+        free(snapshot);
+        return NULL;
+    }
+    const snapshot_header *header = (const snapshot_header *) snapshot->mapping;
+    if (!isValidHeader(header, snapshot->size))
+    {
+        munmap(snapshot->mapping, snapshot->size);
+        free(snapshot);
+        return NULL;
+    }
+    char *base = (char *) snapshot->mapping;
+    snapshot->grid.data = (double *) (base + header->gridOffset);
+    snapshot->grid.n = header->n;
+    snapshot->grid.m = header->m;
+    snapshot->grid.stride = header->stride;
+    snapshot->sources = (source_point *) (base + header->sourcesOffset);
+    snapshot->num_sources = header->numSources;
+    snapshot->params = header->params;
+    snapshot->params.path[SNAPSHOT_PATH_LENGTH - 1] = '\0';
+    return snapshot;
+}
+
+/**
+ * Unmap a snapshot (its grid and sources are gone)
+ * @param snapshot the snapshot (may be NULL)
+ */
+void closeSnapshot(heat_snapshot *snapshot)
+{
+    if (snapshot == NULL)
+    {
+        return;
+    }
+    munmap(snapshot->mapping, snapshot->size);
+    free(snapshot);
+}
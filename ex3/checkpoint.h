@@ -0,0 +1,81 @@
+/**
+ * @file checkpoint.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Snapshots of a calculation, to resume it
+ * @section DESCRIPTION
+ * A snapshot file holds a header (with the parameters of the calculation), then the grid
+ * with its padded rows at a page aligned offset, then the sources. The file is mapped back
+ * as it is (copy on write), so the grid is used in place without parsing anything.
+ * The snapshots are meant to be read by the program which wrote them: the parameters are
+ * stored in the layout of this machine, and a snapshot from another build is refused.
+ */
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdlib.h>
+#include "calculator.h"
+#include "grid.h"
+#include "output.h"
+
+// -------------------------- const definitions -------------------------
+#define SNAPSHOT_MAGIC "HEATSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_PATH_LENGTH 256
+
+/**
+ * Parameters of a calculation, saved with its grid.
+ * iteration is the number of iterations done by the current call of calculateGrid, path is
+ * the file the checkpoints are written to. The functions of the options are not saved.
+ */
+typedef struct
+{
+	double terminate;
+	int n_iter, is_cyclic;
+	calc_options options;
+	output_options output;
+	unsigned int iteration;
+	char path[SNAPSHOT_PATH_LENGTH];
+} snapshot_params;
+
+/**
+ * A snapshot mapped in memory. The cells of grid and the sources are in the mapping.
+ */
+typedef struct
+{
+	heat_grid grid;
+	source_point *sources;
+	size_t num_sources;
+	snapshot_params params;
+	void *mapping;
+	size_t size;
+} heat_snapshot;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Write a snapshot. It is written next to path then renamed, so path always holds a whole
+ * snapshot even if the program is stopped meanwhile.
+ * @param path the file
+ * @param grid the grid
+ * @param sources the sources
+ * @param num_sources number of sources
+ * @param params the parameters of the calculation
+ * @return 1 iff the snapshot was written
+ */
+int writeSnapshot(const char *path, const heat_grid *grid, const source_point *sources,
+                  size_t num_sources, const snapshot_params *params);
+
+/**
+ * Map a snapshot
+ * @param path the file
+ * @return the snapshot, or NULL if it could not be mapped or is not a valid snapshot
+ */
+heat_snapshot *openSnapshot(const char *path);
+
+/**
+ * Unmap a snapshot (its grid and sources are gone)
+ * @param snapshot the snapshot (may be NULL)
+ */
+void closeSnapshot(heat_snapshot *snapshot);
+
+#endif
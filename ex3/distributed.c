@@ -0,0 +1,308 @@
+/**
+ * @file distributed.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Clusters of processes, which share a mapping of anonymous memory: the state of the cluster,
+ * the change of every block, the edge rows of every block, and the cells of the grid they are
+ * written back to.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _DEFAULT_SOURCE
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "distributed.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+/**
+ * The parts of the mapping start on separate cache lines
+ */
+#define PART_ALIGNMENT 64
+#define EDGES 2
+#define TOP_EDGE 0
+#define BOTTOM_EDGE 1
+// ------------------------------ structs -----------------------------
+
+/**
+ * The state of a cluster in the shared mapping.
+ */
+typedef struct
+{
+    pthread_barrier_t barrier;
+    int failed;
+    int stop;
+} cluster_state;
+
+/**
+ * A cluster, seen from one of its processes: the parts of the mapping are changes (one per
+ * process), edges (the top and bottom rows of every block) and cells (the grid, row after
+ * row). children is used by the calling process only.
+ */
+struct cluster
+{
+    unsigned int processes, rank;
+    size_t n, m;
+    pid_t *children;
+    void *mapping;
+    size_t size;
+    cluster_state *state;
+    residual *changes;
+    double *edges;
+    double *cells;
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Round a size of the mapping up to PART_ALIGNMENT
+ * @param size the size
+ * @return the rounded size
+ */
+size_t alignPart(size_t size)
+{
+    return (size + PART_ALIGNMENT - 1) / PART_ALIGNMENT * PART_ALIGNMENT;
+}
+
+/**
+ * Free a cluster in the calling process, after its other processes are gone
+ * @param group the cluster
+ */
+void freeCluster(cluster *group)
+{
+    if (group->mapping != NULL)
+    {
+        pthread_barrier_destroy(&group->state->barrier);
+        munmap(group->mapping, group->size);
+    }
+    free(group->children);
+    free(group);
+}
+
+/**
+ * Map the shared memory of a cluster
+ * @param group the cluster, with its size set
+ * @return 1 iff it could be mapped
+ */
+int mapCluster(cluster *group)
+{
+    size_t states = alignPart(sizeof(cluster_state));
+    size_t changes = alignPart(sizeof(residual) * group->processes);
+    size_t edges = alignPart(sizeof(double) * EDGES * group->m * group->processes);
+    if (group->n > 0 && group->m > SIZE_MAX / sizeof(double) / group->n)
+    {
+        return FALSE;
+    }
+    group->size = states + changes + edges + sizeof(double) * group->n * group->m;
+    void *mapping = mmap(NULL, group->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                         -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        return FALSE;
+    }
+    unsigned char *bytes = (unsigned char *) mapping;
+    group->state = (cluster_state *) bytes;
+    group->changes = (residual *) (bytes + states);
+    group->edges = (double *) (bytes + states + changes);
+    group->cells = (double *) (bytes + states + changes + edges);
+    pthread_barrierattr_t attributes;
+    int shared = pthread_barrierattr_init(&attributes) == 0;
+    shared = shared && pthread_barrierattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED) == 0
+             && pthread_barrier_init(&group->state->barrier, &attributes,
+                                     group->processes) == 0;
+    pthread_barrierattr_destroy(&attributes);
+    if (!shared)
+    {
+        munmap(mapping, group->size);
+        return FALSE;
+    }
+    group->mapping = mapping;
+    group->state->failed = FALSE;
+    group->state->stop = FALSE;
+    return TRUE;
+}
+
+/**
+ * Start a cluster: fork the other processes. The function returns in every process of the
+ * cluster, with its own rank.
+ * @param processes number of processes, including the calling one (at least 1)
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the cluster, or NULL (in the calling process only) if it could not be started
+ */
+cluster *createCluster(unsigned int processes, size_t n, size_t m)
+{
+    cluster *group = (cluster *) calloc(1, sizeof(cluster));
+    if (group == NULL)
+    {
+        return NULL;
+    }
+    group->processes = processes;
+    group->n = n;
+    group->m = m;
+    group->children = (pid_t *) calloc(processes, sizeof(pid_t));
+    if (group->children == NULL || !mapCluster(group))
+    {
+        freeCluster(group);
+        return NULL;
+    }
+    for (unsigned int rank = 1; rank < processes; rank++)
+    {
+        pid_t child = fork();
+        if (child == 0)
+        {
+            group->rank = rank;
+            return group;
+        }
+        if (child < 0)
+        {
+            // The children started wait for the others on the barrier
+            for (unsigned int r = 1; r < rank; r++)
+            {
+                kill(group->children[r], SIGKILL);
+                waitpid(group->children[r], NULL, 0);
+            }
+            freeCluster(group);
+            return NULL;
+        }
+        group->children[rank] = child;
+    }
+    return group;
+}
+
+/**
+ * Get the rank of the process in a cluster
+ * @param group the cluster
+ * @return the rank, 0 for the calling process
+ */
+unsigned int clusterRank(const cluster *group)
+{
+    return group->rank;
+}
+
+/**
+ * Get the number of processes of a cluster
+ * @param group the cluster
+ * @return the number of processes
+ */
+unsigned int clusterSize(const cluster *group)
+{
+    return group->processes;
+}
+
+/**
+ * Wait until every process of the cluster reaches this point
+ * @param group the cluster
+ * @param ok 0 if the process failed
+ * @return 1 iff no process failed so far
+ */
+int syncCluster(cluster *group, int ok)
+{
+    if (!ok)
+    {
+        group->state->failed = TRUE;
+    }
+    pthread_barrier_wait(&group->state->barrier);
+    return !group->state->failed;
+}
+
+/**
+ * Swap the edge rows of the blocks: set the halo rows of the block of the process.
+ * A process writes its edges before the barrier, and reads those of its neighbors after it.
+ * They are written again after the barrier of reduceChanges, when every process read them.
+ * @param group the cluster
+ * @param block the block of the process: the halo row, its rows, the halo row
+ * @param is_cyclic tell how to deal with borders
+ */
+void exchangeHalos(cluster *group, heat_grid *block, int is_cyclic)
+{
+    size_t m = group->m, bytes = m * sizeof(double), last = block->n - 2;
+    unsigned int rank = group->rank, processes = group->processes;
+    double *own = group->edges + (size_t) rank * EDGES * m;
+    memcpy(own + TOP_EDGE * m, GRID_ROW(block, 1), bytes);
+    memcpy(own + BOTTOM_EDGE * m, GRID_ROW(block, last), bytes);
+    pthread_barrier_wait(&group->state->barrier);
+    // The halos at the borders of a grid which is not cyclic stay zero
+    int cyclic = is_cyclic >= TRUE;
+    if (rank > 0 || cyclic)
+    {
+        unsigned int above = rank > 0 ? rank - 1 : processes - 1;
+        memcpy(GRID_ROW(block, 0), group->edges + ((size_t) above * EDGES + BOTTOM_EDGE) * m,
+               bytes);
+    }
+    if (rank + 1 < processes || cyclic)
+    {
+        unsigned int below = rank + 1 < processes ? rank + 1 : 0;
+        memcpy(GRID_ROW(block, last + 1),
+               group->edges + ((size_t) below * EDGES + TOP_EDGE) * m, bytes);
+    }
+}
+
+/**
+ * Add the changes of the blocks of an iteration, in rank order, and tell every process if the
+ * calling process stops. Like the edges, stop is written again after the barrier of
+ * exchangeHalos, when every process read it.
+ * @param group the cluster
+ * @param change the change of the block of the process
+ * @param total set to the change of the grid
+ * @param stop 1 if the calling process stops after this iteration (ignored in the others)
+ * @return the stop of the calling process
+ */
+int reduceChanges(cluster *group, const residual *change, residual *total, int stop)
+{
+    group->changes[group->rank] = *change;
+    if (group->rank == 0)
+    {
+        group->state->stop = stop;
+    }
+    pthread_barrier_wait(&group->state->barrier);
+    *total = group->changes[0];
+    for (unsigned int rank = 1; rank < group->processes; rank++)
+    {
+        mergeChange(total, &group->changes[rank]);
+    }
+    return group->state->stop;
+}
+
+/**
+ * Leave a cluster: write the block of the process to the grid. The other processes exit, and
+ * the calling process waits for them.
+ * @param group the cluster
+ * @param block the block of the process (with its halo rows), NULL if the process failed
+ * @param first first row of the block in the grid
+ * @param grid the grid, updated in the calling process
+ * @return 1 iff every process wrote its block
+ */
+int leaveCluster(cluster *group, const heat_grid *block, size_t first, heat_grid *grid)
+{
+    size_t m = group->m;
+    for (size_t i = 1; block != NULL && i + 1 < block->n; i++)
+    {
+        memcpy(group->cells + (first + i - 1) * m, GRID_ROW(block, i), m * sizeof(double));
+    }
+    if (group->rank > 0)
+    {
+        // The buffers of the calling process were copied too: they are not flushed again
+        _exit(block != NULL ? 0 : 1);
+    }
+    int done = block != NULL;
+    for (unsigned int rank = 1; rank < group->processes; rank++)
+    {
+        int status;
+        done = waitpid(group->children[rank], &status, 0) == group->children[rank]
+               && WIFEXITED(status) && WEXITSTATUS(status) == 0 && done;
+    }
+    for (size_t i = 0; done && i < group->n; i++)
+    {
+        memcpy(GRID_ROW(grid, i), group->cells + i * m, m * sizeof(double));
+    }
+    freeCluster(group);
+    return done;
+}
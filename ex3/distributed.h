@@ -0,0 +1,91 @@
+/**
+ * @file distributed.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Processes sharing the rows of a calculation
+ * @section DESCRIPTION
+ * A cluster is the calling process (rank 0) and processes forked from it, which split the rows
+ * of a grid into blocks (see firstRow). Every process keeps its block in its own memory, with
+ * a halo row above and below it: the last row of the block above and the first row of the
+ * block below (wrapped around in a cyclic grid, zeros at the borders of the others). Before an
+ * iteration the processes swap their edge rows through a shared memory mailbox, and after it
+ * every process adds the changes of all the blocks in rank order, so they all see the same
+ * diff and stop together. The blocks are written back to the grid of the calling process when
+ * the processes leave the cluster.
+ * The processes wait for each other on process shared barriers: a process which dies leaves
+ * the others waiting.
+ */
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "kernel.h"
+
+/**
+ * The processes of a calculation, seen from one of them.
+ */
+typedef struct cluster cluster;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Start a cluster: fork the other processes. The function returns in every process of the
+ * cluster, with its own rank.
+ * @param processes number of processes, including the calling one (at least 1)
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the cluster, or NULL (in the calling process only) if it could not be started
+ */
+cluster *createCluster(unsigned int processes, size_t n, size_t m);
+
+/**
+ * Get the rank of the process in a cluster
+ * @param group the cluster
+ * @return the rank, 0 for the calling process
+ */
+unsigned int clusterRank(const cluster *group);
+
+/**
+ * Get the number of processes of a cluster
+ * @param group the cluster
+ * @return the number of processes
+ */
+unsigned int clusterSize(const cluster *group);
+
+/**
+ * Wait until every process of the cluster reaches this point
+ * @param group the cluster
+ * @param ok 0 if the process failed
+ * @return 1 iff no process failed so far
+ */
+int syncCluster(cluster *group, int ok);
+
+/**
+ * Swap the edge rows of the blocks: set the halo rows of the block of the process
+ * @param group the cluster
+ * @param block the block of the process: the halo row, its rows, the halo row
+ * @param is_cyclic tell how to deal with borders
+ */
+void exchangeHalos(cluster *group, heat_grid *block, int is_cyclic);
+
+/**
+ * Add the changes of the blocks of an iteration, in rank order, and tell every process if the
+ * calling process stops
+ * @param group the cluster
+ * @param change the change of the block of the process
+ * @param total set to the change of the grid
+ * @param stop 1 if the calling process stops after this iteration (ignored in the others)
+ * @return the stop of the calling process
+ */
+int reduceChanges(cluster *group, const residual *change, residual *total, int stop);
+
+/**
+ * Leave a cluster: write the block of the process to the grid. The other processes exit, and
+ * the calling process waits for them.
+ * @param group the cluster
+ * @param block the block of the process (with its halo rows), NULL if the process failed
+ * @param first first row of the block in the grid
+ * @param grid the grid, updated in the calling process
+ * @return 1 iff every process wrote its block
+ */
+int leaveCluster(cluster *group, const heat_grid *block, size_t first, heat_grid *grid);
+
+#endif
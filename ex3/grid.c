@@ -0,0 +1,256 @@
+/**
+ * @file grid.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Allocation and conversion of contiguous grids.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _POSIX_C_SOURCE 200112L
+#include <stdint.h>
+#include <string.h>
+#include "grid.h"
+// -------------------------- const definitions -------------------------
+#define CELLS_PER_LINE (GRID_ALIGNMENT / sizeof(double))
+#define FLOATS_PER_LINE (GRID_ALIGNMENT / sizeof(float))
+// ------------------------------ functions -----------------------------
+
+/**
+ * Get the stride of the rows of a grid: the width padded to a whole number of cache lines
+ * @param m width of the grid
+ * @return the stride, or 0 if it overflows
+ */
+size_t gridStride(size_t m)
+{
+    size_t stride = (m + CELLS_PER_LINE - 1) / CELLS_PER_LINE * CELLS_PER_LINE;
+    return stride < m ? 0 : stride;
+}
+
+/**
+ * Allocate a grid without writing its cells, so that the pages of a big grid are placed (on the
+ * memory node of the thread) as they are first written
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+heat_grid *reserveGrid(size_t n, size_t m)
+{
+    size_t stride = gridStride(m);
+    if (stride < m || (n > 0 && stride > SIZE_MAX / sizeof(double) / n))
+    {
+        return NULL;
+    }
+    heat_grid *grid = (heat_grid *) malloc(sizeof(heat_grid));
+    if (grid == NULL)
+    {
+        return NULL;
+    }
+    size_t bytes = n * stride * sizeof(double);
+    void *data = NULL;
+    if (posix_memalign(&data, GRID_ALIGNMENT, bytes > 0 ? bytes : GRID_ALIGNMENT) != 0)
+    {
+        free(grid);
+        return NULL;
+    }
+    grid->data = (double *) data;
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    return grid;
+}
+
+/**
+ * Allocate a zero filled grid
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+heat_grid *allocGrid(size_t n, size_t m)
+{
+    heat_grid *grid = reserveGrid(n, m);
+    if (grid != NULL)
+    {
+        memset(grid->data, 0, n * grid->stride * sizeof(double));
+    }
+    return grid;
+}
+
+/**
+ * Free a grid allocated with allocGrid or reserveGrid (NULL is ignored)
+ * @param grid the grid
+ */
+void freeGrid(heat_grid *grid)
+{
+    if (grid == NULL)
+    {
+        return;
+    }
+    free(grid->data);
+    free(grid);
+}
+
+/**
+ * Allocate a zero filled float grid
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+float_grid *allocFloatGrid(size_t n, size_t m)
+{
+    size_t stride = (m + FLOATS_PER_LINE - 1) / FLOATS_PER_LINE * FLOATS_PER_LINE;
+    if (stride < m || (n > 0 && stride > SIZE_MAX / sizeof(float) / n))
+    {
+        return NULL;
+    }
+    float_grid *grid = (float_grid *) malloc(sizeof(float_grid));
+    if (grid == NULL)
+    {
+        return NULL;
+    }
+    size_t bytes = n * stride * sizeof(float);
+    void *data = NULL;
+    if (posix_memalign(&data, GRID_ALIGNMENT, bytes > 0 ? bytes : GRID_ALIGNMENT) != 0)
+    {
+        free(grid);
+        return NULL;
+    }
+    memset(data, 0, bytes);
+    grid->data = (float *) data;
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    return grid;
+}
+
+/**
+ * Free a grid allocated with allocFloatGrid (NULL is ignored)
+ * @param grid the grid
+ */
+void freeFloatGrid(float_grid *grid)
+{
+    if (grid == NULL)
+    {
+        return;
+    }
+    free(grid->data);
+    free(grid);
+}
+
+/**
+ * Round the cells of a grid to floats
+ * @param dst the float grid, of the same size
+ * @param src the grid
+ */
+void narrowGrid(float_grid *dst, const heat_grid *src)
+{
+    for (size_t i = 0; i < src->n; i++)
+    {
+        const double *row = GRID_ROW(src, i);
+        float *out = GRID_ROW(dst, i);
+        for (size_t j = 0; j < src->m; j++)
+        {
+            out[j] = (float) row[j];
+        }
+    }
+}
+
+/**
+ * Get a zero filled grid from a pool
+ * @param pool the pool
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+heat_grid *takeGrid(grid_pool *pool, size_t n, size_t m)
+{
+    size_t stride = gridStride(m);
+    if (stride < m || (n > 0 && stride > SIZE_MAX / sizeof(double) / n))
+    {
+        return NULL;
+    }
+    size_t bytes = n * stride * sizeof(double);
+    size_t best = pool->count;
+    for (size_t k = 0; k < pool->count; k++)
+    {
+        if (pool->capacity[k] >= bytes && pool->capacity[k] / GRID_POOL_SLACK <= bytes
+            && (best == pool->count || pool->capacity[k] < pool->capacity[best]))
+        {
+            best = k;
+        }
+    }
+    if (best == pool->count)
+    {
+        return allocGrid(n, m);
+    }
+    heat_grid *grid = pool->grids[best];
+    pool->count--;
+    pool->grids[best] = pool->grids[pool->count];
+    pool->capacity[best] = pool->capacity[pool->count];
+    memset(grid->data, 0, bytes);
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    return grid;
+}
+
+/**
+ * Give a grid back to a pool, it is freed if the pool is full
+ * @param pool the pool
+ * @param grid the grid (may be NULL)
+ */
+void returnGrid(grid_pool *pool, heat_grid *grid)
+{
+    if (grid == NULL)
+    {
+        return;
+    }
+    if (pool->count == GRID_POOL_SIZE)
+    {
+        freeGrid(grid);
+        return;
+    }
+    // Only the cells in use are known to be allocated
+    pool->grids[pool->count] = grid;
+    pool->capacity[pool->count] = grid->n * grid->stride * sizeof(double);
+    pool->count++;
+}
+
+/**
+ * Free the grids of a pool
+ * @param pool the pool
+ */
+void clearGridPool(grid_pool *pool)
+{
+    for (size_t k = 0; k < pool->count; k++)
+    {
+        freeGrid(pool->grids[k]);
+    }
+    pool->count = 0;
+}
+
+/**
+ * Copy an array of rows into the grid
+ * @param grid the grid
+ * @param rows n rows of m cells each
+ */
+void loadRows(heat_grid *grid, double **rows)
+{
+    for (size_t i = 0; i < grid->n; i++)
+    {
+        memcpy(GRID_ROW(grid, i), rows[i], grid->m * sizeof(double));
+    }
+}
+
+/**
+ * Copy the grid back into an array of rows
+ * @param grid the grid
+ * @param rows n rows of m cells each
+ */
+void storeRows(const heat_grid *grid, double **rows)
+{
+    for (size_t i = 0; i < grid->n; i++)
+    {
+        memcpy(rows[i], GRID_ROW(grid, i), grid->m * sizeof(double));
+    }
+}
@@ -0,0 +1,164 @@
+/**
+ * @file grid.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Contiguous grid storage for the heat calculator
+ * @section DESCRIPTION
+ * A grid is kept in one cache-line aligned buffer. Every row starts on a cache line and is
+ * padded up to a multiple of the SIMD width, so row i starts at data + i * stride.
+ * A float grid is laid out the same way with float cells; it holds a copy of a grid for the
+ * sweeps in single precision.
+ */
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdlib.h>
+
+// -------------------------- const definitions -------------------------
+/**
+ * Alignment (in bytes) of the buffer and of every row.
+ */
+#define GRID_ALIGNMENT 64
+
+/**
+ * Number of free grids a grid pool keeps.
+ */
+#define GRID_POOL_SIZE 4
+
+/**
+ * A free grid of a pool is reused for a grid of at least 1 / GRID_POOL_SLACK of its size.
+ */
+#define GRID_POOL_SLACK 4
+
+// ------------------------------ macros -----------------------------
+/**
+ * Pointer to the first cell of row i.
+ */
+#define GRID_ROW(grid, i) ((grid)->data + (size_t)(i) * (grid)->stride)
+
+/**
+ * The cell at row i, column j.
+ */
+#define GRID_AT(grid, i, j) (GRID_ROW(grid, i)[j])
+
+/**
+ * Structure to hold a grid of n rows and m columns.
+ */
+typedef struct
+{
+	double *data;
+	size_t n, m;
+	size_t stride;
+} heat_grid;
+
+/**
+ * Structure to hold a grid of n rows and m columns of floats.
+ */
+typedef struct
+{
+	float *data;
+	size_t n, m;
+	size_t stride;
+} float_grid;
+
+/**
+ * Free grids kept to be used again by one thread: the cells of grids[k] take capacity[k]
+ * bytes.
+ */
+typedef struct
+{
+	heat_grid *grids[GRID_POOL_SIZE];
+	size_t capacity[GRID_POOL_SIZE];
+	size_t count;
+} grid_pool;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Get the stride of the rows of a grid: the width padded to a whole number of cache lines
+ * @param m width of the grid
+ * @return the stride, or 0 if it overflows
+ */
+size_t gridStride(size_t m);
+
+/**
+ * Allocate a grid without writing its cells, so that the pages of a big grid are placed (on the
+ * memory node of the thread) as they are first written
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+heat_grid *reserveGrid(size_t n, size_t m);
+
+/**
+ * Allocate a zero filled grid
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+heat_grid *allocGrid(size_t n, size_t m);
+
+/**
+ * Free a grid allocated with allocGrid or reserveGrid (NULL is ignored)
+ * @param grid the grid
+ */
+void freeGrid(heat_grid *grid);
+
+/**
+ * Get a zero filled grid from a pool: the smallest free grid big enough, if it is not much
+ * bigger, or else a new grid
+ * @param pool the pool (zero filled when it is first used)
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+heat_grid *takeGrid(grid_pool *pool, size_t n, size_t m);
+
+/**
+ * Give a grid of allocGrid or takeGrid back to a pool, it is freed if the pool is full
+ * @param pool the pool
+ * @param grid the grid (may be NULL)
+ */
+void returnGrid(grid_pool *pool, heat_grid *grid);
+
+/**
+ * Free the grids of a pool, which is then empty
+ * @param pool the pool
+ */
+void clearGridPool(grid_pool *pool);
+
+/**
+ * Allocate a zero filled float grid
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the allocation failed
+ */
+float_grid *allocFloatGrid(size_t n, size_t m);
+
+/**
+ * Free a grid allocated with allocFloatGrid (NULL is ignored)
+ * @param grid the grid
+ */
+void freeFloatGrid(float_grid *grid);
+
+/**
+ * Round the cells of a grid to floats
+ * @param dst the float grid, of the same size
+ * @param src the grid
+ */
+void narrowGrid(float_grid *dst, const heat_grid *src);
+
+/**
+ * Copy an array of rows into the grid
+ * @param grid the grid
+ * @param rows n rows of m cells each
+ */
+void loadRows(heat_grid *grid, double **rows);
+
+/**
+ * Copy the grid back into an array of rows
+ * @param grid the grid
+ * @param rows n rows of m cells each
+ */
+void storeRows(const heat_grid *grid, double **rows);
+
+#endif
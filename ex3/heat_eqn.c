@@ -5,6 +5,7 @@
  *      Author: OWNER
  */
 
+#include "heat_eqn.h"
 
 /**
  * A discrete form of the heat equation.
@@ -13,9 +14,9 @@ double heat_eqn(double cell, double right, double top, double left, double botto
 {
 	/*
 	 * For simplicity, we have set D = dt = dx = 1;
+	 * dphiDx = right + left - 2 * cell, dphiDy = top + bottom - 2 * cell,
+	 * and (dphiDx + dphiDy) / 4 + cell - the cell cancels out.
 	 */
-	double dphiDx = right + left; // - 2 * cell
-	double dphiDy = top + bottom; // - 2 * cell
-	return (dphiDx + dphiDy) / 4; // + cell - cancels out.
+	return HEAT_EQN(cell, right, top, left, bottom);
 }
 
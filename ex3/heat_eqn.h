@@ -8,6 +8,11 @@
 #ifndef HEAT_EQN_H_
 #define HEAT_EQN_H_
 
+/**
+ * The update of heat_eqn as an expression, so the calculator can inline it in its sweeps.
+ */
+#define HEAT_EQN(cell, right, top, left, bottom) ((((right) + (left)) + ((top) + (bottom))) / 4)
+
 double heat_eqn(double cell, double right, double top, double left, double bottom);
 
 #endif /* HEAT_EQN_H_ */
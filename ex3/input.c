@@ -0,0 +1,324 @@
+/**
+ * @file input.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Map a file in memory and parse its lines in place.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "input.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define READ_CHUNK 65536
+/**
+ * Numbers with at most that many significant digits and a power of ten up to MAX_EXACT_POWER
+ * are exact doubles, so one multiplication or division gives the correctly rounded value.
+ */
+#define MAX_EXACT_DIGITS 15
+#define MAX_EXACT_POWER 22
+/**
+ * Longest number handed to strtod when it is not exact.
+ */
+#define MAX_NUMBER_LENGTH 128
+// ------------------------------ functions -----------------------------
+
+/**
+ * Read a file which cannot be mapped, at once
+ * @param input the file to fill
+ * @param fd the file descriptor
+ * @return 1 iff the file could be read
+ */
+int readInput(input_file *input, int fd)
+{
+    size_t capacity = 0;
+    while (TRUE)
+    {
+        if (input->size + READ_CHUNK > capacity)
+        {
+            capacity = 2 * capacity + READ_CHUNK;
+            char *data = (char *) realloc(input->data, capacity);
+            if (data == NULL)
+            {
+                return FALSE;
+            }
+            input->data = data;
+        }
+        ssize_t count = read(fd, input->data + input->size, capacity - input->size);
+        if (count < 0)
+        {
+            return FALSE;
+        }
+        if (count == 0)
+        {
+            return TRUE;
+        }
+        input->size += (size_t) count;
+    }
+}
+
+/**
+ * Open a file
+ * @param path path of the file
+ * @return the file, or NULL if it could not be read
+ */
+input_file *openInput(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    input_file *input = (input_file *) calloc(1, sizeof(input_file));
+    struct stat status;
+    if (input != NULL && fstat(fd, &status) == 0 && S_ISREG(status.st_mode)
+        && status.st_size > 0)
+    {
+        void *data = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            posix_madvise(data, (size_t) status.st_size, POSIX_MADV_SEQUENTIAL);
+            input->data = (char *) data;
+            input->size = (size_t) status.st_size;
+            input->mapped = TRUE;
+        }
+    }
+    if (input != NULL && !input->mapped && !readInput(input, fd))
+    {
+        closeInput(input);
+        input = NULL;
+    }
+    close(fd);
+    return input;
+}
+
+/**
+ * Close a file
+ * @param input the file (may be NULL)
+ */
+void closeInput(input_file *input)
+{
+    if (input == NULL)
+    {
+        return;
+    }
+    if (input->mapped)
+    {
+        munmap(input->data, input->size);
+    }
+    else
+    {
+        free(input->data);
+    }
+    free(input);
+}
+
+/**
+ * Get the next line of the file
+ * @param input the file, whose line is the number of that line (from 1)
+ * @param line the line
+ * @return 1 iff there was a line left
+ */
+int nextLine(input_file *input, input_line *line)
+{
+    if (input->position >= input->size)
+    {
+        return FALSE;
+    }
+    const char *begin = input->data + input->position;
+    const char *newline = (const char *) memchr(begin, '\n', input->size - input->position);
+    const char *end = newline != NULL ? newline : input->data + input->size;
+    input->position = (size_t) (end - input->data) + (newline != NULL);
+    input->line++;
+    while (end > begin && end[-1] == '\r')
+    {
+        end--;
+    }
+    line->begin = begin;
+    line->end = end;
+    return TRUE;
+}
+
+/**
+ * Skip the spaces and tabs at the beginning of a line
+ * @param line the line
+ * @return 1 iff the line is left empty
+ */
+int skipBlanks(input_line *line)
+{
+    while (line->begin < line->end && (*line->begin == ' ' || *line->begin == '\t'))
+    {
+        line->begin++;
+    }
+    return line->begin == line->end;
+}
+
+/**
+ * Skip a character (after blanks) at the beginning of a line
+ * @param line the line
+ * @param c the character
+ * @return 1 iff the character was there
+ */
+int skipChar(input_line *line, char c)
+{
+    if (skipBlanks(line) || *line->begin != c)
+    {
+        return FALSE;
+    }
+    line->begin++;
+    return TRUE;
+}
+
+/**
+ * Tell if a character is a decimal digit
+ * @param c the character
+ * @return 1 iff it is a digit
+ */
+int isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * Parse an integer (after blanks) at the beginning of a line
+ * @param line the line
+ * @param value the integer
+ * @return 1 iff there was an integer which fits a long
+ */
+int parseInteger(input_line *line, long *value)
+{
+    skipBlanks(line);
+    const char *p = line->begin, *end = line->end;
+    int negative = p < end && *p == '-';
+    p += p < end && (*p == '-' || *p == '+');
+    if (p == end || !isDigit(*p))
+    {
+        return FALSE;
+    }
+    unsigned long magnitude = 0;
+    unsigned long limit = negative ? (unsigned long) LONG_MAX + 1 : (unsigned long) LONG_MAX;
+    for (; p < end && isDigit(*p); p++)
+    {
+        unsigned long digit = (unsigned long) (*p - '0');
+        if (magnitude > (limit - digit) / 10)
+        {
+            return FALSE;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+    *value = negative ? (long) (0 - magnitude) : (long) magnitude;
+    line->begin = p;
+    return TRUE;
+}
+
+/**
+ * Parse a real number with strtod, for the numbers the fast path cannot round exactly
+ * @param begin first character of the number
+ * @param end end of the number
+ * @param value the number
+ * @return 1 iff strtod read the whole number
+ */
+int parseRealSlow(const char *begin, const char *end, double *value)
+{
+    char text[MAX_NUMBER_LENGTH];
+    size_t length = (size_t) (end - begin);
+    if (length >= MAX_NUMBER_LENGTH)
+    {
+        return FALSE;
+    }
+    memcpy(text, begin, length);
+    text[length] = '\0';
+    char *stop;
+    *value = strtod(text, &stop);
+    return stop == text + length;
+}
+
+/**
+ * Parse a real number (after blanks) at the beginning of a line, like strtod
+ * @param line the line
+ * @param value the number
+ * @return 1 iff there was a number
+ */
+int parseReal(input_line *line, double *value)
+{
+    static const double powers[MAX_EXACT_POWER + 1] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    skipBlanks(line);
+    const char *begin = line->begin, *p = begin, *end = line->end;
+    int negative = p < end && *p == '-';
+    p += p < end && (*p == '-' || *p == '+');
+    uint64_t mantissa = 0;
+    int digits = 0, seen = 0;
+    long exponent = 0;
+    for (; p < end && isDigit(*p); p++, seen++)
+    {
+        if (mantissa != 0 || *p != '0')
+        {
+            mantissa = digits < MAX_EXACT_DIGITS + 1 ? mantissa * 10 + (uint64_t) (*p - '0')
+                                                     : mantissa;
+            exponent += digits >= MAX_EXACT_DIGITS + 1;
+            digits++;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && isDigit(*p); p++, seen++)
+        {
+            if (mantissa != 0 || *p != '0')
+            {
+                if (digits < MAX_EXACT_DIGITS + 1)
+                {
+                    mantissa = mantissa * 10 + (uint64_t) (*p - '0');
+                    exponent--;
+                }
+                digits++;
+            }
+            else
+            {
+                exponent--;
+            }
+        }
+    }
+    if (seen == 0)
+    {
+        return FALSE;
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        input_line rest = {p + 1, end};
+        long power;
+        if (rest.begin == end || !(isDigit(*rest.begin) || *rest.begin == '-'
+                                   || *rest.begin == '+') || !parseInteger(&rest, &power))
+        {
+            return FALSE;
+        }
+        p = rest.begin;
+        exponent = power > LONG_MAX / 2 || power < LONG_MIN / 2 ? power : exponent + power;
+    }
+    line->begin = p;
+    if (mantissa == 0)
+    {
+        *value = negative ? -0.0 : 0.0;
+        return TRUE;
+    }
+    if (digits > MAX_EXACT_DIGITS || exponent > MAX_EXACT_POWER || exponent < -MAX_EXACT_POWER)
+    {
+        return parseRealSlow(begin, p, value);
+    }
+    double result = (double) mantissa;
+    result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+    *value = negative ? -result : result;
+    return TRUE;
+}
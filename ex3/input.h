@@ -0,0 +1,90 @@
+/**
+ * @file input.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Single pass reading of a text file
+ * @section DESCRIPTION
+ * The file is mapped in memory (or read at once when it cannot be mapped, like a pipe), then
+ * walked line by line. The numbers are parsed in place, without copying the lines.
+ */
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdlib.h>
+
+/**
+ * Structure to hold an open file and the position of the next line.
+ */
+typedef struct
+{
+	char *data;
+	size_t size;
+	size_t position;
+	unsigned long line;
+	int mapped;
+} input_file;
+
+/**
+ * A line of the file, without its end of line characters.
+ * begin is moved forward as the line is parsed.
+ */
+typedef struct
+{
+	const char *begin;
+	const char *end;
+} input_line;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Open a file
+ * @param path path of the file
+ * @return the file, or NULL if it could not be read
+ */
+input_file *openInput(const char *path);
+
+/**
+ * Close a file
+ * @param input the file (may be NULL)
+ */
+void closeInput(input_file *input);
+
+/**
+ * Get the next line of the file
+ * @param input the file, whose line is the number of that line (from 1)
+ * @param line the line
+ * @return 1 iff there was a line left
+ */
+int nextLine(input_file *input, input_line *line);
+
+/**
+ * Skip the spaces and tabs at the beginning of a line
+ * @param line the line
+ * @return 1 iff the line is left empty
+ */
+int skipBlanks(input_line *line);
+
+/**
+ * Skip a character (after blanks) at the beginning of a line
+ * @param line the line
+ * @param c the character
+ * @return 1 iff the character was there
+ */
+int skipChar(input_line *line, char c);
+
+/**
+ * Parse an integer (after blanks) at the beginning of a line
+ * @param line the line
+ * @param value the integer
+ * @return 1 iff there was an integer which fits a long
+ */
+int parseInteger(input_line *line, long *value);
+
+/**
+ * Parse a real number (after blanks) at the beginning of a line, like strtod
+ * @param line the line
+ * @param value the number
+ * @return 1 iff there was a number
+ */
+int parseReal(input_line *line, double *value);
+
+#endif
@@ -0,0 +1,268 @@
+/**
+ * @file kernel.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Stencil sweeps: the inner cells read their neighbors directly, only the first and last rows
+ * and columns go through the cyclic or zero border handling. The sources split every row into
+ * spans of cells to update.
+ * The sweeps are written once in kernel_template.h, and instantiated for the functions we know
+ * (with their update inlined) and for any other function (called through the pointer).
+ */
+
+// ------------------------------ includes ------------------------------
+#include <math.h>
+#include "kernel.h"
+#include "heat_eqn.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+// ------------------------------ macros -----------------------------
+#define UNUSED(x) (void)(x)
+// ------------------------------ functions -----------------------------
+
+/**
+ * Reset a change, whose sum is added up in double
+ * @param change the change
+ * @param norms 1 to compute the norms too
+ */
+void clearChange(residual *change, int norms)
+{
+    change->norms = norms;
+    change->mode = SUM_DOUBLE;
+    change->delta = 0;
+    change->carry = 0;
+    change->l1 = 0;
+    change->l2 = 0;
+    change->linf = 0;
+}
+
+/**
+ * Add the change of a cell
+ * @param change the change
+ * @param delta new value - old value of the cell
+ */
+void addChange(residual *change, double delta)
+{
+    if (change->mode == SUM_FLOAT)
+    {
+        change->delta = (float) change->delta + (float) delta;
+    }
+    else if (change->mode == SUM_KAHAN)
+    {
+        float sum = (float) change->delta, carry = (float) change->carry;
+        KAHAN_ADD(sum, carry, delta);
+        change->delta = sum;
+        change->carry = carry;
+    }
+    else
+    {
+        change->delta += delta;
+    }
+    if (change->norms)
+    {
+        double size = fabs(delta);
+        change->l1 += size;
+        change->l2 += delta * delta;
+        change->linf = size > change->linf ? size : change->linf;
+    }
+}
+
+/**
+ * Add a change to another one
+ * @param change the change to update
+ * @param other the change to add
+ */
+void mergeChange(residual *change, const residual *other)
+{
+    if (change->mode == SUM_KAHAN)
+    {
+        float sum = (float) change->delta, carry = (float) change->carry;
+        KAHAN_ADD(sum, carry, other->delta);
+        KAHAN_ADD(sum, carry, -other->carry);
+        change->delta = sum;
+        change->carry = carry;
+    }
+    else if (change->mode == SUM_FLOAT)
+    {
+        change->delta = (float) change->delta + (float) other->delta;
+    }
+    else
+    {
+        change->delta += other->delta - other->carry;
+    }
+    change->l1 += other->l1;
+    change->l2 += other->l2;
+    change->linf = other->linf > change->linf ? other->linf : change->linf;
+}
+
+// ------------------------------ instances -----------------------------
+
+/*
+ * Generic sweeps, which call the function for every cell.
+ */
+#define CELL double
+#define GRID heat_grid
+#define INTERIOR heat_interior_func
+#define KERNEL(name) name##Generic
+#define APPLY(cell, right, top, left, bottom) function(cell, right, top, left, bottom)
+#include "kernel_template.h"
+#undef KERNEL
+#undef APPLY
+
+/*
+ * Sweeps of heat_eqn, with the update inlined.
+ */
+#define KERNEL(name) name##Heat
+#define APPLY(cell, right, top, left, bottom) HEAT_EQN(cell, right, top, left, bottom)
+#define KERNEL_VECTOR
+#include "kernel_template.h"
+#undef KERNEL
+#undef APPLY
+#undef KERNEL_VECTOR
+#undef CELL
+#undef GRID
+#undef INTERIOR
+
+/*
+ * The same sweeps on float grids.
+ */
+#define CELL float
+#define GRID float_grid
+#define INTERIOR heat_interior32_func
+#define KERNEL_FLOAT
+#define KERNEL(name) name##FloatGeneric
+#define APPLY(cell, right, top, left, bottom) function(cell, right, top, left, bottom)
+#include "kernel_template.h"
+#undef KERNEL
+#undef APPLY
+
+#define KERNEL(name) name##FloatHeat
+#define APPLY(cell, right, top, left, bottom) HEAT_EQN(cell, right, top, left, bottom)
+#define KERNEL_VECTOR
+#include "kernel_template.h"
+#undef KERNEL
+#undef APPLY
+#undef KERNEL_VECTOR
+#undef KERNEL_FLOAT
+#undef CELL
+#undef GRID
+#undef INTERIOR
+
+// ------------------------------ dispatch -----------------------------
+
+/**
+ * Update the rows [from, to) of the grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void updateRows(diff_func function, heat_interior_func interior, heat_grid *dst,
+                const heat_grid *src, const source_index *index, int is_cyclic, size_t from,
+                size_t to, residual *change)
+{
+    if (function == heat_eqn)
+    {
+        updateRowsHeat(function, interior, dst, src, index, is_cyclic, from, to, change);
+        return;
+    }
+    updateRowsGeneric(function, NULL, dst, src, index, is_cyclic, from, to, change);
+}
+
+/**
+ * Update the cells [from, to) of a row of the grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void updateBlock(diff_func function, heat_interior_func interior, heat_grid *dst,
+                 const heat_grid *src, const source_index *index, int is_cyclic, size_t i,
+                 size_t from, size_t to, residual *change)
+{
+    if (function == heat_eqn)
+    {
+        updateBlockHeat(function, interior, dst, src, index, is_cyclic, i, from, to, change);
+        return;
+    }
+    updateBlockGeneric(function, NULL, dst, src, index, is_cyclic, i, from, to, change);
+}
+
+/**
+ * Update the cells of one colour in the rows [from, to) of the grid
+ * @param function function to apply
+ * @param grid the grid, updated in place
+ * @param index the sources of the grid, which are left as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param colour colour of the cells to update: (i + j) % 2
+ * @param change the change of the sweep, updated
+ */
+void updateColour(diff_func function, heat_grid *grid, const source_index *index,
+                  int is_cyclic, size_t from, size_t to, int colour, residual *change)
+{
+    if (function == heat_eqn)
+    {
+        updateColourHeat(function, grid, index, is_cyclic, from, to, colour, change);
+        return;
+    }
+    updateColourGeneric(function, grid, index, is_cyclic, from, to, colour, change);
+}
+
+/**
+ * Update the rows [from, to) of a float grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void updateRowsFloat(diff_func function, heat_interior32_func interior, float_grid *dst,
+                     const float_grid *src, const source_index *index, int is_cyclic,
+                     size_t from, size_t to, residual *change)
+{
+    if (function == heat_eqn)
+    {
+        updateRowsFloatHeat(function, interior, dst, src, index, is_cyclic, from, to, change);
+        return;
+    }
+    updateRowsFloatGeneric(function, NULL, dst, src, index, is_cyclic, from, to, change);
+}
+
+/**
+ * Update the cells of one colour in the rows [from, to) of a float grid
+ * @param function function to apply
+ * @param grid the grid, updated in place
+ * @param index the sources of the grid, which are left as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param colour colour of the cells to update: (i + j) % 2
+ * @param change the change of the sweep, updated
+ */
+void updateColourFloat(diff_func function, float_grid *grid, const source_index *index,
+                       int is_cyclic, size_t from, size_t to, int colour, residual *change)
+{
+    if (function == heat_eqn)
+    {
+        updateColourFloatHeat(function, grid, index, is_cyclic, from, to, colour, change);
+        return;
+    }
+    updateColourFloatGeneric(function, grid, index, is_cyclic, from, to, colour, change);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file kernel.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Stencil sweeps of the heat calculator
+ * @section DESCRIPTION
+ * A sweep reads the cells of a source grid and writes the new values to a destination grid.
+ * When both are the same grid the cells are updated in place (Gauss-Seidel), otherwise every
+ * cell is computed from the values of the previous iteration (Jacobi). A colour sweep updates
+ * half of the cells, as a checkerboard, in place (red-black). The float sweeps do the same on
+ * float grids.
+ */
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "calculator.h"
+#include "sources.h"
+#include "simd.h"
+
+/**
+ * Change of the cells in a sweep: the sum of the changes of the cells (new - old) and, if
+ * norms is set, the sum of their absolute values (l1), of their squares (l2) and the biggest
+ * absolute value (linf).
+ * The sum is added up as mode says; with SUM_KAHAN it is delta - carry. The norms are always
+ * added up in double.
+ */
+typedef struct
+{
+	int norms;
+	sum_mode mode;
+	double delta, carry;
+	double l1, l2, linf;
+} residual;
+
+/**
+ * Reset a change, whose sum is added up in double
+ * @param change the change
+ * @param norms 1 to compute the norms too
+ */
+void clearChange(residual *change, int norms);
+
+/**
+ * Add the change of a cell
+ * @param change the change
+ * @param delta new value - old value of the cell
+ */
+void addChange(residual *change, double delta);
+
+/**
+ * Add a change to another one
+ * @param change the change to update
+ * @param other the change to add
+ */
+void mergeChange(residual *change, const residual *other);
+
+/**
+ * Update the rows [from, to) of the grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void updateRows(diff_func function, heat_interior_func interior, heat_grid *dst,
+                const heat_grid *src, const source_index *index, int is_cyclic, size_t from,
+                size_t to, residual *change);
+
+/**
+ * Update the cells [from, to) of a row of the grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void updateBlock(diff_func function, heat_interior_func interior, heat_grid *dst,
+                 const heat_grid *src, const source_index *index, int is_cyclic, size_t i,
+                 size_t from, size_t to, residual *change);
+
+/**
+ * Update the cells of one colour in the rows [from, to) of the grid.
+ * The cell (i, j) has colour (i + j) % 2, its neighbors inside the grid have the other one.
+ * @param function function to apply
+ * @param grid the grid, updated in place
+ * @param index the sources of the grid, which are left as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param colour colour of the cells to update (0 or 1)
+ * @param change the change of the sweep, updated
+ */
+void updateColour(diff_func function, heat_grid *grid, const source_index *index,
+                  int is_cyclic, size_t from, size_t to, int colour, residual *change);
+
+/**
+ * Update the rows [from, to) of a float grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void updateRowsFloat(diff_func function, heat_interior32_func interior, float_grid *dst,
+                     const float_grid *src, const source_index *index, int is_cyclic,
+                     size_t from, size_t to, residual *change);
+
+/**
+ * Update the cells of one colour in the rows [from, to) of a float grid
+ * @param function function to apply
+ * @param grid the grid, updated in place
+ * @param index the sources of the grid, which are left as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param colour colour of the cells to update (0 or 1)
+ * @param change the change of the sweep, updated
+ */
+void updateColourFloat(diff_func function, float_grid *grid, const source_index *index,
+                       int is_cyclic, size_t from, size_t to, int colour, residual *change);
+
+#endif
@@ -0,0 +1,369 @@
+/**
+ * @file kernel_template.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Template of the stencil sweeps
+ * @section DESCRIPTION
+ * Included by kernel.c once per instance, with:
+ * KERNEL(name) - the name of the instance of a function
+ * APPLY(cell, right, top, left, bottom) - the update of a cell, which may call function
+ * CELL, GRID, INTERIOR - the type of the cells, of the grids and of the interior sweep
+ * KERNEL_VECTOR - defined if the inner cells of a Jacobi sweep may use the interior sweep
+ * KERNEL_FLOAT - defined for float cells, whose changes are added up as the change says
+ * No include guard on purpose.
+ */
+
+/**
+ * Apply the function on a border cell, where the neighbors wrap around the grid
+ * @param function function to apply
+ * @param grid the grid
+ * @param i i coord
+ * @param j j coord
+ * @return the new value of the cell
+ */
+CELL KERNEL(updateCyclicCell)(diff_func function, const GRID *grid, size_t i, size_t j)
+{
+    UNUSED(function);
+    size_t n = grid->n, m = grid->m;
+    const CELL *row = GRID_ROW(grid, i);
+    return (CELL) APPLY(row[j], row[j + 1 == m ? 0 : j + 1],
+                 GRID_AT(grid, i == 0 ? n - 1 : i - 1, j),
+                        row[j == 0 ? m - 1 : j - 1],
+                        GRID_AT(grid, i + 1 == n ? 0 : i + 1, j));
+}
+
+/**
+ * Apply the function on a border cell, where the neighbors outside the grid are 0
+ * @param function function to apply
+ * @param grid the grid
+ * @param i i coord
+ * @param j j coord
+ * @return the new value of the cell
+ */
+CELL KERNEL(updateZeroCell)(diff_func function, const GRID *grid, size_t i, size_t j)
+{
+    UNUSED(function);
+    size_t n = grid->n, m = grid->m;
+    const CELL *row = GRID_ROW(grid, i);
+    return (CELL) APPLY(row[j], j + 1 < m ? row[j + 1] : 0,
+                 i > 0 ? GRID_AT(grid, i - 1, j) : 0,
+                        j > 0 ? row[j - 1] : 0,
+                        i + 1 < n ? GRID_AT(grid, i + 1, j) : 0);
+}
+
+/**
+ * Update a border cell
+ * @param function function to apply
+ * @param dst grid to write to
+ * @param src grid to read from
+ * @param is_cyclic tell how to deal with borders
+ * @param i i coord
+ * @param j j coord
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateBorderCell)(diff_func function, GRID *dst, const GRID *src,
+                              int is_cyclic, size_t i, size_t j, residual *change)
+{
+    CELL value = is_cyclic >= TRUE ? KERNEL(updateCyclicCell)(function, src, i, j)
+                                   : KERNEL(updateZeroCell)(function, src, i, j);
+    addChange(change, (double) value - GRID_AT(src, i, j));
+    GRID_AT(dst, i, j) = value;
+}
+
+/**
+ * Update the cells [from, to) of a border row, or the border columns of an inner row
+ * @param function function to apply
+ * @param dst grid to write to
+ * @param src grid to read from
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateBorder)(diff_func function, GRID *dst, const GRID *src,
+                          int is_cyclic, size_t i, size_t from, size_t to, residual *change)
+{
+    for (size_t j = from; j < to; j++)
+    {
+        KERNEL(updateBorderCell)(function, dst, src, is_cyclic, i, j, change);
+    }
+}
+
+/**
+ * Update the cells [from, to) of an inner row, all their neighbors are inside the grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells, NULL for none
+ * @param dst grid to write to
+ * @param src grid to read from
+ * @param i row of the cells (0 < i < n - 1)
+ * @param from first column (at least 1)
+ * @param to end column (at most m - 1)
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateInterior)(diff_func function, INTERIOR interior, GRID *dst,
+                            const GRID *src, size_t i, size_t from, size_t to,
+                            residual *change)
+{
+    UNUSED(function);
+    UNUSED(interior);
+    CELL *out = GRID_ROW(dst, i);
+    const CELL *row = GRID_ROW(src, i);
+    const CELL *up = row - src->stride;
+    const CELL *down = row + src->stride;
+#ifdef KERNEL_VECTOR
+    if (interior != NULL && dst != src && !change->norms)
+    {
+#ifdef KERNEL_FLOAT
+        change->delta = interior(out, up, row, down, from, to, change->mode, &change->carry,
+                                 change->delta);
+#else
+        change->delta = interior(out, up, row, down, from, to, change->delta);
+#endif
+        return;
+    }
+#endif
+#ifdef KERNEL_FLOAT
+    if (!change->norms && change->mode != SUM_DOUBLE)
+    {
+        // The float sum and its carry stay in registers too
+        int kahan = change->mode == SUM_KAHAN;
+        float sum = (float) change->delta, carry = (float) change->carry;
+        for (size_t j = from; j < to; j++)
+        {
+            CELL value = (CELL) APPLY(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+            if (kahan)
+            {
+                KAHAN_ADD(sum, carry, value - row[j]);
+            }
+            else
+            {
+                sum += value - row[j];
+            }
+            out[j] = value;
+        }
+        change->delta = sum;
+        change->carry = carry;
+        return;
+    }
+#endif
+    if (change->norms || change->mode != SUM_DOUBLE)
+    {
+        for (size_t j = from; j < to; j++)
+        {
+            CELL value = (CELL) APPLY(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+            addChange(change, (double) value - row[j]);
+            out[j] = value;
+        }
+        return;
+    }
+    // The sum of the changes stays in a register, out may be the same row as row
+    double delta = change->delta;
+    for (size_t j = from; j < to; j++)
+    {
+        CELL value = (CELL) APPLY(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+        delta += (double) value - row[j];
+        out[j] = value;
+    }
+    change->delta = delta;
+}
+
+/**
+ * Update the cells [from, to) of a row, none of them is a source
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells, NULL for none
+ * @param dst grid to write to
+ * @param src grid to read from
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateSpan)(diff_func function, INTERIOR interior, GRID *dst,
+                        const GRID *src, int is_cyclic, size_t i, size_t from, size_t to,
+                        residual *change)
+{
+    size_t n = src->n, m = src->m;
+    if (from >= to)
+    {
+        return;
+    }
+    if (i == 0 || i + 1 == n || m < 3)
+    {
+        KERNEL(updateBorder)(function, dst, src, is_cyclic, i, from, to, change);
+        return;
+    }
+    if (from == 0)
+    {
+        KERNEL(updateBorderCell)(function, dst, src, is_cyclic, i, 0, change);
+        from = 1;
+    }
+    size_t inner = to < m - 1 ? to : m - 1;
+    if (from < inner)
+    {
+        KERNEL(updateInterior)(function, interior, dst, src, i, from, inner, change);
+    }
+    if (to == m)
+    {
+        KERNEL(updateBorderCell)(function, dst, src, is_cyclic, i, m - 1, change);
+    }
+}
+
+/**
+ * Update the cells [from, to) of a row
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells, NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateBlock)(diff_func function, INTERIOR interior, GRID *dst,
+                         const GRID *src, const source_index *index, int is_cyclic, size_t i,
+                         size_t from, size_t to, residual *change)
+{
+    const CELL *row = GRID_ROW(src, i);
+    CELL *out = GRID_ROW(dst, i);
+    size_t first = from;
+    for (size_t k = index->rowStart[i]; k < index->rowStart[i + 1]; k++)
+    {
+        size_t source = index->cols[k];
+        if (source < from)
+        {
+            continue;
+        }
+        if (source >= to)
+        {
+            break;
+        }
+        KERNEL(updateSpan)(function, interior, dst, src, is_cyclic, i, first, source, change);
+        out[source] = row[source];
+        first = source + 1;
+    }
+    KERNEL(updateSpan)(function, interior, dst, src, is_cyclic, i, first, to, change);
+}
+
+/**
+ * Update the rows [from, to) of the grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells, NULL for none
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateRows)(diff_func function, INTERIOR interior, GRID *dst,
+                        const GRID *src, const source_index *index, int is_cyclic,
+                        size_t from, size_t to, residual *change)
+{
+    for (size_t i = from; i < to; i++)
+    {
+        KERNEL(updateBlock)(function, interior, dst, src, index, is_cyclic, i, 0, src->m,
+                            change);
+    }
+}
+
+/**
+ * Update the cells of one colour in [from, to) of a row, none of them is a source
+ * @param function function to apply
+ * @param grid the grid, updated in place
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param colour colour of the cells to update: (i + j) % 2
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateColourSpan)(diff_func function, GRID *grid, int is_cyclic, size_t i,
+                              size_t from, size_t to, int colour, residual *change)
+{
+    UNUSED(function);
+    size_t n = grid->n, m = grid->m;
+    CELL *row = GRID_ROW(grid, i);
+    size_t j = from + ((i + from + (size_t) colour) & 1);
+    if (i == 0 || i + 1 == n || m < 3)
+    {
+        for (; j < to; j += 2)
+        {
+            KERNEL(updateBorderCell)(function, grid, grid, is_cyclic, i, j, change);
+        }
+        return;
+    }
+    const CELL *up = row - grid->stride;
+    const CELL *down = row + grid->stride;
+    if (j == 0 && j < to)
+    {
+        KERNEL(updateBorderCell)(function, grid, grid, is_cyclic, i, 0, change);
+        j = 2;
+    }
+    size_t inner = to < m - 1 ? to : m - 1;
+#ifdef KERNEL_FLOAT
+    if (!change->norms && change->mode != SUM_DOUBLE)
+    {
+        // The float sum and its carry stay in registers
+        int kahan = change->mode == SUM_KAHAN;
+        float sum = (float) change->delta, carry = (float) change->carry;
+        for (; j < inner; j += 2)
+        {
+            CELL value = (CELL) APPLY(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+            if (kahan)
+            {
+                KAHAN_ADD(sum, carry, value - row[j]);
+            }
+            else
+            {
+                sum += value - row[j];
+            }
+            row[j] = value;
+        }
+        change->delta = sum;
+        change->carry = carry;
+    }
+#endif
+    for (; j < inner; j += 2)
+    {
+        CELL value = (CELL) APPLY(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+        addChange(change, (double) value - row[j]);
+        row[j] = value;
+    }
+    if (j == m - 1 && j < to)
+    {
+        KERNEL(updateBorderCell)(function, grid, grid, is_cyclic, i, j, change);
+    }
+}
+
+/**
+ * Update the cells of one colour in the rows [from, to) of the grid
+ * @param function function to apply
+ * @param grid the grid, updated in place
+ * @param index the sources of the grid, which are left as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param colour colour of the cells to update: (i + j) % 2
+ * @param change the change of the sweep, updated
+ */
+void KERNEL(updateColour)(diff_func function, GRID *grid, const source_index *index,
+                          int is_cyclic, size_t from, size_t to, int colour, residual *change)
+{
+    size_t m = grid->m;
+    for (size_t i = from; i < to; i++)
+    {
+        size_t first = 0;
+        for (size_t k = index->rowStart[i]; k < index->rowStart[i + 1]; k++)
+        {
+            KERNEL(updateColourSpan)(function, grid, is_cyclic, i, first, index->cols[k],
+                                     colour, change);
+            first = index->cols[k] + 1;
+        }
+        KERNEL(updateColourSpan)(function, grid, is_cyclic, i, first, m, colour, change);
+    }
+}
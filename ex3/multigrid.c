@@ -0,0 +1,529 @@
+/**
+ * @file multigrid.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Aggregation multigrid cycles.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <string.h>
+#include "multigrid.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define PRE_SWEEPS 2
+#define POST_SWEEPS 2
+#define COARSEST_SWEEPS 4
+#define COARSE_VISITS 2
+/**
+ * Weight of a neighbor in the equation of a cell of the grid (heat_eqn averages 4 neighbors).
+ */
+#define NEIGHBOR_WEIGHT 0.25
+// ------------------------------ structs -----------------------------
+
+/**
+ * A coarse level. The correction equation of the cell p is
+ * diag(p) * error(p) - the weighted errors of its neighbors = rhs(p), where east(p) is the
+ * weight of the cell at its right and south(p) the weight of the cell below it (the weights
+ * are symmetric). A cell with a zero diag has no equation, its error stays 0.
+ */
+typedef struct
+{
+    heat_grid *diag, *east, *south;
+    heat_grid *error, *rhs, *res;
+} multigrid_level;
+
+/**
+ * The levels: levels[0] aggregates the cells of the grid, levels[count - 1] is a single cell.
+ * previous and update are buffers of the size of the grid.
+ */
+struct multigrid
+{
+    size_t count;
+    multigrid_level *levels;
+    heat_grid *previous, *update;
+    int is_cyclic;
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Get the next cell along a row or a column
+ * @param k the cell
+ * @param size size of the row or column
+ * @param is_cyclic tell how to deal with borders
+ * @return the next cell, or size if there is none
+ */
+size_t nextCell(size_t k, size_t size, int is_cyclic)
+{
+    return k + 1 < size ? k + 1 : (is_cyclic >= TRUE ? 0 : size);
+}
+
+/**
+ * Get the previous cell along a row or a column
+ * @param k the cell
+ * @param size size of the row or column
+ * @param is_cyclic tell how to deal with borders
+ * @return the previous cell, or size if there is none
+ */
+size_t previousCell(size_t k, size_t size, int is_cyclic)
+{
+    return k > 0 ? k - 1 : (is_cyclic >= TRUE ? size - 1 : size);
+}
+
+/**
+ * Tell if a cell of the grid is a source
+ * @param index the sources of the grid
+ * @param i i coord
+ * @param j j coord
+ * @return 1 iff it is
+ */
+int isSource(const source_index *index, size_t i, size_t j)
+{
+    size_t low = index->rowStart[i], high = index->rowStart[i + 1];
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (index->cols[middle] < j)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low < index->rowStart[i + 1] && index->cols[low] == j;
+}
+
+/**
+ * Get the weight between a cell and a neighbor in a level, or in the grid
+ * @param weights the east or south weights of the level, NULL for the grid
+ * @param index the sources of the grid
+ * @param i i coord of the cell
+ * @param j j coord of the cell
+ * @param ni i coord of the neighbor
+ * @param nj j coord of the neighbor
+ * @return the weight (0 if one of them is a source of the grid)
+ */
+double weightOf(const heat_grid *weights, const source_index *index, size_t i, size_t j,
+                size_t ni, size_t nj)
+{
+    if (weights != NULL)
+    {
+        return GRID_AT(weights, i, j);
+    }
+    return isSource(index, i, j) || isSource(index, ni, nj) ? 0 : NEIGHBOR_WEIGHT;
+}
+
+/**
+ * Sum the equations of a level (or of the grid) over the aggregates of 2 x 2 cells.
+ * A weight inside an aggregate moves to its diag (twice, once per cell), the others add up
+ * between the aggregates.
+ * @param fine the level, NULL for the grid
+ * @param index the sources of the grid
+ * @param n height of the level
+ * @param m width of the level
+ * @param is_cyclic tell how to deal with borders
+ * @param coarse the next level, zero filled
+ */
+void coarsenLevel(const multigrid_level *fine, const source_index *index, size_t n, size_t m,
+                  int is_cyclic, multigrid_level *coarse)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t south = nextCell(i, n, is_cyclic);
+        for (size_t j = 0; j < m; j++)
+        {
+            size_t east = nextCell(j, m, is_cyclic);
+            double *diag = &GRID_AT(coarse->diag, i / 2, j / 2);
+            *diag += fine != NULL ? GRID_AT(fine->diag, i, j) : !isSource(index, i, j);
+            if (east < m)
+            {
+                double weight = weightOf(fine != NULL ? fine->east : NULL, index, i, j, i, east);
+                if (east / 2 == j / 2)
+                {
+                    *diag -= 2 * weight;
+                }
+                else
+                {
+                    GRID_AT(coarse->east, i / 2, j / 2) += weight;
+                }
+            }
+            if (south < n)
+            {
+                double weight = weightOf(fine != NULL ? fine->south : NULL, index, i, j, south,
+                                         j);
+                if (south / 2 == i / 2)
+                {
+                    *diag -= 2 * weight;
+                }
+                else
+                {
+                    GRID_AT(coarse->south, i / 2, j / 2) += weight;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Sum the weighted errors of the neighbors of a cell of a level
+ * @param level the level
+ * @param i i coord
+ * @param j j coord
+ * @param is_cyclic tell how to deal with borders
+ * @return the sum
+ */
+double neighborSum(const multigrid_level *level, size_t i, size_t j, int is_cyclic)
+{
+    const heat_grid *error = level->error;
+    size_t n = error->n, m = error->m;
+    size_t east = nextCell(j, m, is_cyclic), west = previousCell(j, m, is_cyclic);
+    size_t south = nextCell(i, n, is_cyclic), north = previousCell(i, n, is_cyclic);
+    double sum = 0;
+    if (east < m)
+    {
+        sum += GRID_AT(level->east, i, j) * GRID_AT(error, i, east);
+    }
+    if (west < m)
+    {
+        sum += GRID_AT(level->east, i, west) * GRID_AT(error, i, west);
+    }
+    if (south < n)
+    {
+        sum += GRID_AT(level->south, i, j) * GRID_AT(error, south, j);
+    }
+    if (north < n)
+    {
+        sum += GRID_AT(level->south, north, j) * GRID_AT(error, north, j);
+    }
+    return sum;
+}
+
+/**
+ * One in place sweep of the correction equations of a level
+ * @param level the level
+ * @param is_cyclic tell how to deal with borders
+ */
+void relaxLevel(multigrid_level *level, int is_cyclic)
+{
+    for (size_t i = 0; i < level->error->n; i++)
+    {
+        for (size_t j = 0; j < level->error->m; j++)
+        {
+            double diag = GRID_AT(level->diag, i, j);
+            if (diag > 0)
+            {
+                GRID_AT(level->error, i, j) = (GRID_AT(level->rhs, i, j)
+                                               + neighborSum(level, i, j, is_cyclic)) / diag;
+            }
+        }
+    }
+}
+
+/**
+ * Compute the residual of the correction equations of a level
+ * @param level the level
+ * @param is_cyclic tell how to deal with borders
+ */
+void measureLevel(multigrid_level *level, int is_cyclic)
+{
+    for (size_t i = 0; i < level->error->n; i++)
+    {
+        for (size_t j = 0; j < level->error->m; j++)
+        {
+            double diag = GRID_AT(level->diag, i, j);
+            GRID_AT(level->res, i, j) = diag > 0 ? GRID_AT(level->rhs, i, j)
+                                                   + neighborSum(level, i, j, is_cyclic)
+                                                   - diag * GRID_AT(level->error, i, j) : 0;
+        }
+    }
+}
+
+/**
+ * Get the step along the error of a level which minimises the energy of the error of the
+ * finer level: (error . rhs) / (error . the equations of error)
+ * @param level the level, with its error
+ * @param is_cyclic tell how to deal with borders
+ * @return the step, 0 if the error has no energy
+ */
+double stepLength(const multigrid_level *level, int is_cyclic)
+{
+    double gain = 0, energy = 0;
+    for (size_t i = 0; i < level->error->n; i++)
+    {
+        for (size_t j = 0; j < level->error->m; j++)
+        {
+            double error = GRID_AT(level->error, i, j);
+            gain += error * GRID_AT(level->rhs, i, j);
+            energy += error * (GRID_AT(level->diag, i, j) * error
+                               - neighborSum(level, i, j, is_cyclic));
+        }
+    }
+    return energy > 0 ? gain / energy : 0;
+}
+
+/**
+ * Add the residuals of the cells of an aggregate up, as the right hand side of its equation
+ * @param res the residuals of the finer level
+ * @param rhs the right hand sides of the coarser level
+ */
+void restrictResidual(const heat_grid *res, heat_grid *rhs)
+{
+    memset(rhs->data, 0, rhs->n * rhs->stride * sizeof(double));
+    for (size_t i = 0; i < res->n; i++)
+    {
+        const double *row = GRID_ROW(res, i);
+        double *out = GRID_ROW(rhs, i / 2);
+        for (size_t j = 0; j < res->m; j++)
+        {
+            out[j / 2] += row[j];
+        }
+    }
+}
+
+/**
+ * Add the scaled error of every aggregate to its cells which have an equation
+ * @param fine the finer level
+ * @param coarse the coarser level
+ * @param step the scale
+ */
+void prolongLevel(multigrid_level *fine, const multigrid_level *coarse, double step)
+{
+    for (size_t i = 0; i < fine->error->n; i++)
+    {
+        double *row = GRID_ROW(fine->error, i);
+        const double *diag = GRID_ROW(fine->diag, i);
+        const double *error = GRID_ROW(coarse->error, i / 2);
+        for (size_t j = 0; j < fine->error->m; j++)
+        {
+            if (diag[j] > 0)
+            {
+                row[j] += step * error[j / 2];
+            }
+        }
+    }
+}
+
+/**
+ * Add the scaled error of every aggregate to its cells in the grid, except the sources
+ * @param grid the grid
+ * @param coarse the first level
+ * @param index the sources of the grid
+ * @param step the scale
+ */
+void prolongGrid(heat_grid *grid, const multigrid_level *coarse, const source_index *index,
+                 double step)
+{
+    for (size_t i = 0; i < grid->n; i++)
+    {
+        double *row = GRID_ROW(grid, i);
+        const double *error = GRID_ROW(coarse->error, i / 2);
+        size_t source = index->rowStart[i], end = index->rowStart[i + 1];
+        for (size_t j = 0; j < grid->m; j++)
+        {
+            if (source < end && index->cols[source] == j)
+            {
+                source++;
+                continue;
+            }
+            row[j] += step * error[j / 2];
+        }
+    }
+}
+
+/**
+ * Solve the correction equations of a level approximately, from a zero error: sweeps, then
+ * COARSE_VISITS times the correction of the next level, then sweeps
+ * @param solver the levels
+ * @param k the level
+ */
+void cycleLevel(multigrid *solver, size_t k)
+{
+    multigrid_level *level = &solver->levels[k];
+    memset(level->error->data, 0, level->error->n * level->error->stride * sizeof(double));
+    if (k + 1 == solver->count)
+    {
+        for (int sweep = 0; sweep < COARSEST_SWEEPS; sweep++)
+        {
+            relaxLevel(level, solver->is_cyclic);
+        }
+        return;
+    }
+    multigrid_level *coarse = &solver->levels[k + 1];
+    for (int sweep = 0; sweep < PRE_SWEEPS; sweep++)
+    {
+        relaxLevel(level, solver->is_cyclic);
+    }
+    for (int visit = 0; visit < COARSE_VISITS; visit++)
+    {
+        measureLevel(level, solver->is_cyclic);
+        restrictResidual(level->res, coarse->rhs);
+        cycleLevel(solver, k + 1);
+        prolongLevel(level, coarse, stepLength(coarse, solver->is_cyclic));
+    }
+    for (int sweep = 0; sweep < POST_SWEEPS; sweep++)
+    {
+        relaxLevel(level, solver->is_cyclic);
+    }
+}
+
+/**
+ * Free the grids of a level
+ * @param level the level
+ */
+void freeLevel(multigrid_level *level)
+{
+    freeGrid(level->diag);
+    freeGrid(level->east);
+    freeGrid(level->south);
+    freeGrid(level->error);
+    freeGrid(level->rhs);
+    freeGrid(level->res);
+}
+
+/**
+ * Allocate the zero filled grids of a level
+ * @param level the level
+ * @param n height of the level
+ * @param m width of the level
+ * @return 1 iff they could be allocated
+ */
+int allocLevel(multigrid_level *level, size_t n, size_t m)
+{
+    level->diag = allocGrid(n, m);
+    level->east = allocGrid(n, m);
+    level->south = allocGrid(n, m);
+    level->error = allocGrid(n, m);
+    level->rhs = allocGrid(n, m);
+    level->res = allocGrid(n, m);
+    return level->diag != NULL && level->east != NULL && level->south != NULL
+           && level->error != NULL && level->rhs != NULL && level->res != NULL;
+}
+
+/**
+ * Build the coarse levels of a grid
+ * @param grid the grid
+ * @param index the sources of the grid
+ * @param is_cyclic tell how to deal with borders
+ * @return the levels, or NULL if they could not be allocated
+ */
+multigrid *createMultigrid(const heat_grid *grid, const source_index *index, int is_cyclic)
+{
+    multigrid *solver = (multigrid *) calloc(1, sizeof(multigrid));
+    if (solver == NULL)
+    {
+        return NULL;
+    }
+    solver->is_cyclic = is_cyclic;
+    size_t n = grid->n, m = grid->m;
+    while (n > 1 || m > 1)
+    {
+        n = (n + 1) / 2;
+        m = (m + 1) / 2;
+        solver->count++;
+    }
+    solver->levels = (multigrid_level *) calloc(solver->count > 0 ? solver->count : 1,
+                                                sizeof(multigrid_level));
+    solver->previous = allocGrid(grid->n, grid->m);
+    solver->update = allocGrid(grid->n, grid->m);
+    int allocated = solver->levels != NULL && solver->previous != NULL
+                    && solver->update != NULL;
+    n = grid->n;
+    m = grid->m;
+    for (size_t k = 0; allocated && k < solver->count; k++)
+    {
+        allocated = allocLevel(&solver->levels[k], (n + 1) / 2, (m + 1) / 2);
+        if (allocated)
+        {
+            coarsenLevel(k > 0 ? &solver->levels[k - 1] : NULL, index, n, m, is_cyclic,
+                         &solver->levels[k]);
+        }
+        n = (n + 1) / 2;
+        m = (m + 1) / 2;
+    }
+    if (!allocated)
+    {
+        freeMultigrid(solver);
+        return NULL;
+    }
+    return solver;
+}
+
+/**
+ * Free the levels of a grid
+ * @param solver the levels (may be NULL)
+ */
+void freeMultigrid(multigrid *solver)
+{
+    if (solver == NULL)
+    {
+        return;
+    }
+    for (size_t k = 0; solver->levels != NULL && k < solver->count; k++)
+    {
+        freeLevel(&solver->levels[k]);
+    }
+    free(solver->levels);
+    freeGrid(solver->previous);
+    freeGrid(solver->update);
+    free(solver);
+}
+
+/**
+ * One cycle of the grid: in place sweeps, the correction of the first level, in place sweeps
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn, NULL for none
+ * @param grid the grid, updated in place
+ * @param solver the levels of the grid
+ * @param index the sources of the grid, which are left as is
+ * @param is_cyclic tell how to deal with borders
+ * @param change the change of the grid in the cycle, updated
+ */
+void cycleMultigrid(diff_func function, heat_interior_func interior, heat_grid *grid,
+                    multigrid *solver, const source_index *index, int is_cyclic,
+                    residual *change)
+{
+    size_t bytes = grid->n * grid->stride * sizeof(double);
+    memcpy(solver->previous->data, grid->data, bytes);
+    residual sweeps;
+    clearChange(&sweeps, FALSE);
+    for (int sweep = 0; sweep < PRE_SWEEPS; sweep++)
+    {
+        updateRows(function, NULL, grid, grid, index, is_cyclic, 0, grid->n, &sweeps);
+    }
+    if (solver->count > 0)
+    {
+        // The residual of a cell is its Jacobi update minus its value
+        heat_grid *update = solver->update;
+        updateRows(function, interior, update, grid, index, is_cyclic, 0, grid->n, &sweeps);
+        for (size_t i = 0; i < grid->n; i++)
+        {
+            double *out = GRID_ROW(update, i);
+            const double *row = GRID_ROW(grid, i);
+            for (size_t j = 0; j < grid->m; j++)
+            {
+                out[j] -= row[j];
+            }
+        }
+        multigrid_level *coarse = &solver->levels[0];
+        restrictResidual(update, coarse->rhs);
+        cycleLevel(solver, 0);
+        prolongGrid(grid, coarse, index, stepLength(coarse, is_cyclic));
+    }
+    for (int sweep = 0; sweep < POST_SWEEPS; sweep++)
+    {
+        updateRows(function, NULL, grid, grid, index, is_cyclic, 0, grid->n, &sweeps);
+    }
+    for (size_t i = 0; i < grid->n; i++)
+    {
+        const double *row = GRID_ROW(grid, i);
+        const double *old = GRID_ROW(solver->previous, i);
+        for (size_t j = 0; j < grid->m; j++)
+        {
+            addChange(change, row[j] - old[j]);
+        }
+    }
+}
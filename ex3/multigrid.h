@@ -0,0 +1,57 @@
+/**
+ * @file multigrid.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Multigrid cycles of the heat calculator
+ * @section DESCRIPTION
+ * A cycle relaxes the grid with the usual in place sweeps, then corrects it with the
+ * correction of a coarser grid, in which every cell is an aggregate of 2 x 2 cells of the finer
+ * one. The correction equation of a level is the one of the finer level summed over the
+ * aggregates (so the sources, the zero or cyclic borders and the odd sizes are handled by the
+ * same rule), and it is solved by cycles on the next coarser level, down to a single cell.
+ * Every correction is scaled by the step which minimises the energy of the error along it,
+ * which makes up for the too stiff aggregated equations. The coarse levels are corrected twice
+ * per cycle (a W-cycle below the grid): a single correction (a V-cycle) needs more cycles as
+ * the grid grows, two keep the number of cycles about the same for every size.
+ * The equations are those of heat_eqn: a cell is the average of its 4 neighbors.
+ */
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include "kernel.h"
+
+/**
+ * The coarse levels and the buffers of the cycles of a grid.
+ */
+typedef struct multigrid multigrid;
+
+/**
+ * Build the coarse levels of a grid
+ * @param grid the grid
+ * @param index the sources of the grid
+ * @param is_cyclic tell how to deal with borders
+ * @return the levels, or NULL if they could not be allocated
+ */
+multigrid *createMultigrid(const heat_grid *grid, const source_index *index, int is_cyclic);
+
+/**
+ * Free the levels of a grid
+ * @param solver the levels (may be NULL)
+ */
+void freeMultigrid(multigrid *solver);
+
+/**
+ * One cycle of the grid
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn, NULL for none
+ * @param grid the grid, updated in place
+ * @param solver the levels of the grid
+ * @param index the sources of the grid, which are left as is
+ * @param is_cyclic tell how to deal with borders
+ * @param change the change of the grid in the cycle, updated
+ */
+void cycleMultigrid(diff_func function, heat_interior_func interior, heat_grid *grid,
+                    multigrid *solver, const source_index *index, int is_cyclic,
+                    residual *change);
+
+#endif
@@ -0,0 +1,251 @@
+/**
+ * @file numa.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * The processors and nodes of the process, read from the affinity of the calling thread and
+ * the node lists of the kernel, and the pinning of the threads.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numa.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define NODE_DIRECTORY "/sys/devices/system/node"
+#define NODE_FORMAT "node%u%n"
+#define CPU_LIST_FORMAT NODE_DIRECTORY "/node%u/cpulist"
+#define PATH_LENGTH 64
+#define LIST_LENGTH 4096
+// ------------------------------ structs -----------------------------
+
+/**
+ * The layout: the processors the process may run on node after node, their nodes, and the
+ * processors the process could run on.
+ */
+struct numa_layout
+{
+    size_t count;
+    int *cpus;
+    unsigned int *nodes;
+    cpu_set_t allowed;
+};
+
+/**
+ * The threads of a pool to pin.
+ */
+typedef struct
+{
+    const numa_layout *layout;
+    unsigned int threads;
+} pin_run;
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Add the processors of a list of the kernel ("0-3,8,10-11") which the process may run on, and
+ * which were not added yet
+ * @param layout the layout
+ * @param list the list
+ * @param node the node of the processors
+ * @param added the processors added so far, updated
+ */
+void addCpuList(numa_layout *layout, const char *list, unsigned int node, cpu_set_t *added)
+{
+    const char *next = list;
+    while (*next >= '0' && *next <= '9')
+    {
+        char *end;
+        long first = strtol(next, &end, 10), last = first;
+        if (*end == '-')
+        {
+            next = end + 1;
+            last = strtol(next, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &layout->allowed) && !CPU_ISSET(cpu, added))
+            {
+                CPU_SET(cpu, added);
+                layout->cpus[layout->count] = (int) cpu;
+                layout->nodes[layout->count++] = node < MAX_NODES ? node : MAX_NODES - 1;
+            }
+        }
+        next = *end == ',' ? end + 1 : end;
+    }
+}
+
+/**
+ * Get the highest node of the kernel lists
+ * @return the node, -1 if there is no list
+ */
+long getLastNode(void)
+{
+    DIR *directory = opendir(NODE_DIRECTORY);
+    if (directory == NULL)
+    {
+        return -1;
+    }
+    long last = -1;
+    struct dirent *entry;
+    while ((entry = readdir(directory)) != NULL)
+    {
+        unsigned int node;
+        int length = 0;
+        if (sscanf(entry->d_name, NODE_FORMAT, &node, &length) == 1
+            && entry->d_name[length] == '\0' && (long) node > last)
+        {
+            last = (long) node;
+        }
+    }
+    closedir(directory);
+    return last;
+}
+
+/**
+ * Read the processors of the process and their nodes
+ * @return the layout, or NULL if it could not be allocated or the process has no processor
+ */
+numa_layout *readNumaLayout(void)
+{
+    numa_layout *layout = (numa_layout *) calloc(1, sizeof(numa_layout));
+    if (layout == NULL)
+    {
+        return NULL;
+    }
+    int total = 0;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &layout->allowed) == 0)
+    {
+        total = CPU_COUNT(&layout->allowed);
+    }
+    size_t slots = (size_t) (total > 0 ? total : 1);
+    layout->cpus = (int *) malloc(sizeof(int) * slots);
+    layout->nodes = (unsigned int *) malloc(sizeof(unsigned int) * slots);
+    if (total == 0 || layout->cpus == NULL || layout->nodes == NULL)
+    {
+        freeNumaLayout(layout);
+        return NULL;
+    }
+    cpu_set_t added;
+    CPU_ZERO(&added);
+    long last = getLastNode();
+    for (long node = 0; node <= last; node++)
+    {
+        char path[PATH_LENGTH], list[LIST_LENGTH];
+        snprintf(path, sizeof(path), CPU_LIST_FORMAT, (unsigned int) node);
+        FILE *file = fopen(path, "r");
+        if (file == NULL)
+        {
+            continue;
+        }
+        if (fgets(list, sizeof(list), file) != NULL)
+        {
+            addCpuList(layout, list, (unsigned int) node, &added);
+        }
+        fclose(file);
+    }
+    // The processors of no list are on node 0
+    for (int cpu = 0; cpu < CPU_SETSIZE && layout->count < (size_t) total; cpu++)
+    {
+        if (CPU_ISSET(cpu, &layout->allowed) && !CPU_ISSET(cpu, &added))
+        {
+            CPU_SET(cpu, &added);
+            layout->cpus[layout->count] = cpu;
+            layout->nodes[layout->count++] = 0;
+        }
+    }
+    return layout;
+}
+
+/**
+ * Free a layout
+ * @param layout the layout (may be NULL)
+ */
+void freeNumaLayout(numa_layout *layout)
+{
+    if (layout == NULL)
+    {
+        return;
+    }
+    free(layout->cpus);
+    free(layout->nodes);
+    free(layout);
+}
+
+/**
+ * Get the processor of a thread: the threads are spread evenly over the processors in the order
+ * of the layout, so every node gets a share of the threads in proportion to its processors, and
+ * its threads are consecutive (they sweep consecutive rows)
+ * @param layout the layout
+ * @param thread the thread
+ * @param threads number of threads
+ * @return the index of the processor in the layout
+ */
+size_t threadProcessor(const numa_layout *layout, unsigned int thread, unsigned int threads)
+{
+    return (size_t) (thread % threads) * layout->count / threads;
+}
+
+/**
+ * Get the node of a thread
+ * @param layout the layout
+ * @param thread the thread
+ * @param threads number of threads
+ * @return the node of its processor, below MAX_NODES
+ */
+unsigned int threadNode(const numa_layout *layout, unsigned int thread, unsigned int threads)
+{
+    return layout->nodes[threadProcessor(layout, thread, threads)];
+}
+
+/**
+ * Pin the calling thread to its processor
+ * @param layout the layout
+ * @param thread the thread
+ * @param threads number of threads
+ * @return 1 iff it was pinned
+ */
+int pinThread(const numa_layout *layout, unsigned int thread, unsigned int threads)
+{
+    cpu_set_t processor;
+    CPU_ZERO(&processor);
+    CPU_SET(layout->cpus[threadProcessor(layout, thread, threads)], &processor);
+    return sched_setaffinity(0, sizeof(cpu_set_t), &processor) == 0;
+}
+
+/**
+ * Let the calling thread run on every processor of the layout again
+ * @param layout the layout
+ */
+void unpinThread(const numa_layout *layout)
+{
+    sched_setaffinity(0, sizeof(cpu_set_t), &layout->allowed);
+}
+
+/**
+ * The part of one thread in the pinning of a pool
+ * @param arg the threads (pin_run)
+ * @param thread the thread
+ */
+void pinTask(void *arg, unsigned int thread)
+{
+    const pin_run *pin = (const pin_run *) arg;
+    pinThread(pin->layout, thread, pin->threads);
+}
+
+/**
+ * Pin every thread of a pool to its processor, for the life of the pool
+ * @param pool the pool (NULL pins the calling thread as thread 0)
+ * @param layout the layout
+ */
+void pinPool(thread_pool *pool, const numa_layout *layout)
+{
+    pin_run pin = {layout, poolSize(pool)};
+    runPool(pool, pinTask, &pin);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file numa.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Placement of the threads on the processors and memory nodes
+ * @section DESCRIPTION
+ * The layout lists the processors the process may run on, node after node (as the kernel lists
+ * them in /sys/devices/system/node). The threads of a pool are spread evenly over that list, so
+ * every node gets a share of them in proportion to its processors, even with fewer threads than
+ * a node has processors, and the threads of a node are consecutive: they sweep a contiguous
+ * block of rows. Thread t of every pool of the same size runs on the same node, so the rows it
+ * first touches in a pool (see reserveGrid) are on the memory of the node which sweeps them in
+ * the next one. Without the node list, every processor is on node 0.
+ * The calling thread of a pool is pinned too, until unpinThread.
+ */
+#ifndef NUMA_H
+#define NUMA_H
+
+#include "parallel.h"
+#include "profile.h"
+
+// -------------------------- const definitions -------------------------
+/**
+ * Number of nodes told apart, the others count as the last one.
+ */
+#define MAX_NODES PROFILE_NODES
+
+/**
+ * The processors of the process and their nodes.
+ */
+typedef struct numa_layout numa_layout;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Read the processors of the process and their nodes
+ * @return the layout, or NULL if it could not be allocated or the process has no processor
+ */
+numa_layout *readNumaLayout(void);
+
+/**
+ * Free a layout
+ * @param layout the layout (may be NULL)
+ */
+void freeNumaLayout(numa_layout *layout);
+
+/**
+ * Get the node of a thread
+ * @param layout the layout
+ * @param thread the thread
+ * @param threads number of threads
+ * @return the node of its processor, below MAX_NODES
+ */
+unsigned int threadNode(const numa_layout *layout, unsigned int thread, unsigned int threads);
+
+/**
+ * Pin the calling thread to its processor
+ * @param layout the layout
+ * @param thread the thread
+ * @param threads number of threads
+ * @return 1 iff it was pinned
+ */
+int pinThread(const numa_layout *layout, unsigned int thread, unsigned int threads);
+
+/**
+ * Let the calling thread run on every processor of the layout again
+ * @param layout the layout
+ */
+void unpinThread(const numa_layout *layout);
+
+/**
+ * Pin every thread of a pool to its processor, for the life of the pool
+ * @param pool the pool (NULL pins the calling thread as thread 0)
+ * @param layout the layout
+ */
+void pinPool(thread_pool *pool, const numa_layout *layout);
+
+#endif
@@ -0,0 +1,436 @@
+/**
+ * @file outofcore.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Disk grids, and their iterations a band of rows at a time.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "outofcore.h"
+#include "parallel.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define FILE_MODE 0644
+/**
+ * Thread 0 updates the bands, thread 1 moves them between the file and the windows.
+ */
+#define SWEEP_THREADS 2
+// ------------------------------ structs -----------------------------
+
+/**
+ * Buffers of the iterations of a disk grid, and the band being updated and moved.
+ * A window holds a band in its rows 1 .. rows, its row 0 and row rows + 1 are the halo rows:
+ * the updated row above the band and the row below it, as the update of the band sees them.
+ */
+struct disk_sweep
+{
+    size_t band;
+    heat_grid *windows[2];
+    double *wrap; // the last row before the iteration (above the first one in a cyclic grid)
+    double *firstRow; // the first row after its update (below the last one in a cyclic grid)
+    size_t *rowStart; // sources of the window
+    thread_pool *pool;
+    // the band to update
+    diff_func function;
+    const source_index *index;
+    int is_cyclic;
+    residual *change;
+    heat_grid *window;
+    size_t first, rows;
+    int last;
+    // the bands to move
+    disk_grid *grid;
+    heat_grid *moved;
+    size_t writeFirst, writeRows, readFirst, readRows;
+    int failed;
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Read or write bytes of a file at an offset, however many calls it takes
+ * @param fd the file
+ * @param bytes the bytes
+ * @param size number of bytes
+ * @param offset offset in the file
+ * @param write 1 to write, 0 to read
+ * @return 1 iff all the bytes were moved
+ */
+int moveBytes(int fd, char *bytes, size_t size, off_t offset, int write)
+{
+    while (size > 0)
+    {
+        ssize_t count = write ? pwrite(fd, bytes, size, offset) : pread(fd, bytes, size, offset);
+        if (count <= 0)
+        {
+            return FALSE;
+        }
+        bytes += count;
+        size -= (size_t) count;
+        offset += count;
+    }
+    return TRUE;
+}
+
+/**
+ * Create a zero filled disk grid (the file is replaced, and kept when the grid is closed)
+ * @param path the file
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the file could not be created
+ */
+disk_grid *createDiskGrid(const char *path, size_t n, size_t m)
+{
+    size_t stride = gridStride(m);
+    if (stride < m || (n > 0 && stride > SIZE_MAX / sizeof(double) / n))
+    {
+        return NULL;
+    }
+    disk_grid *grid = (disk_grid *) malloc(sizeof(disk_grid));
+    if (grid == NULL)
+    {
+        return NULL;
+    }
+    grid->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, FILE_MODE);
+    grid->n = n;
+    grid->m = m;
+    grid->stride = stride;
+    // A file extended by ftruncate reads as zeros
+    if (grid->fd < 0 || ftruncate(grid->fd, (off_t) (n * stride * sizeof(double))) != 0)
+    {
+        closeDiskGrid(grid);
+        return NULL;
+    }
+    return grid;
+}
+
+/**
+ * Close a disk grid
+ * @param grid the grid (may be NULL)
+ */
+void closeDiskGrid(disk_grid *grid)
+{
+    if (grid == NULL)
+    {
+        return;
+    }
+    if (grid->fd >= 0)
+    {
+        close(grid->fd);
+    }
+    free(grid);
+}
+
+/**
+ * Read rows of a disk grid
+ * @param grid the grid
+ * @param rows where to read rows->n rows (with the width of the grid)
+ * @param first first row to read
+ * @return 1 iff the rows were read
+ */
+int readDiskRows(const disk_grid *grid, heat_grid *rows, size_t first)
+{
+    size_t rowBytes = grid->stride * sizeof(double);
+    return moveBytes(grid->fd, (char *) rows->data, rows->n * rowBytes,
+                     (off_t) (first * rowBytes), FALSE);
+}
+
+/**
+ * Write rows of a disk grid
+ * @param grid the grid
+ * @param rows the rows->n rows to write (with the width of the grid)
+ * @param first first row to write
+ * @return 1 iff the rows were written
+ */
+int writeDiskRows(disk_grid *grid, const heat_grid *rows, size_t first)
+{
+    size_t rowBytes = grid->stride * sizeof(double);
+    return moveBytes(grid->fd, (char *) rows->data, rows->n * rowBytes,
+                     (off_t) (first * rowBytes), TRUE);
+}
+
+/**
+ * Compare two sources by row, then by place in the list (so the last one of a cell wins, like
+ * in a grid in memory), for qsort
+ * @param a first source
+ * @param b second source
+ * @return negative, 0 or positive as a comes before, with or after b
+ */
+int compareSourceRows(const void *a, const void *b)
+{
+    const source_point *first = *(const source_point *const *) a;
+    const source_point *second = *(const source_point *const *) b;
+    if (first->x != second->x)
+    {
+        return first->x < second->x ? -1 : 1;
+    }
+    return first < second ? -1 : first > second;
+}
+
+/**
+ * Set the sources in a disk grid (they must be inside of it)
+ * @param grid the grid
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param band number of rows updated at a time
+ * @return 1 iff the grid could be updated
+ */
+int placeDiskSources(disk_grid *grid, const source_point *sources, size_t num_sources,
+                     size_t band)
+{
+    if (num_sources == 0)
+    {
+        return TRUE;
+    }
+    const source_point **sorted = (const source_point **) malloc(sizeof(source_point *)
+                                                                 * num_sources);
+    heat_grid *rows = allocGrid(band, grid->m);
+    int placed = sorted != NULL && rows != NULL;
+    for (size_t k = 0; placed && k < num_sources; k++)
+    {
+        sorted[k] = &sources[k];
+    }
+    if (placed)
+    {
+        qsort(sorted, num_sources, sizeof(source_point *), compareSourceRows);
+    }
+    for (size_t k = 0; placed && k < num_sources;)
+    {
+        size_t first = (size_t) sorted[k]->x / band * band;
+        heat_grid view = *rows;
+        view.n = first + band < grid->n ? band : grid->n - first;
+        placed = readDiskRows(grid, &view, first);
+        for (; k < num_sources && (size_t) sorted[k]->x < first + view.n; k++)
+        {
+            GRID_AT(&view, (size_t) sorted[k]->x - first, sorted[k]->y) = sorted[k]->value;
+        }
+        placed = placed && writeDiskRows(grid, &view, first);
+    }
+    free(sorted);
+    freeGrid(rows);
+    return placed;
+}
+
+/**
+ * Allocate the buffers and the thread of the iterations of a disk grid
+ * @param grid the grid
+ * @param band number of rows of a band (at least 1)
+ * @return the buffers, or NULL if they could not be allocated
+ */
+disk_sweep *createDiskSweep(const disk_grid *grid, size_t band)
+{
+    disk_sweep *sweep = (disk_sweep *) calloc(1, sizeof(disk_sweep));
+    if (sweep == NULL)
+    {
+        return NULL;
+    }
+    sweep->band = band;
+    sweep->windows[0] = allocGrid(band + 2, grid->m);
+    sweep->windows[1] = allocGrid(band + 2, grid->m);
+    size_t rowBytes = sizeof(double) * (grid->stride > 0 ? grid->stride : 1);
+    sweep->wrap = (double *) malloc(rowBytes);
+    sweep->firstRow = (double *) malloc(rowBytes);
+    sweep->rowStart = (size_t *) malloc(sizeof(size_t) * (band + 3));
+    sweep->pool = createPool(SWEEP_THREADS);
+    if (sweep->windows[0] == NULL || sweep->windows[1] == NULL || sweep->wrap == NULL
+        || sweep->firstRow == NULL || sweep->rowStart == NULL || sweep->pool == NULL)
+    {
+        freeDiskSweep(sweep);
+        return NULL;
+    }
+    return sweep;
+}
+
+/**
+ * Free the buffers and the thread of the iterations of a disk grid
+ * @param sweep the buffers (may be NULL)
+ */
+void freeDiskSweep(disk_sweep *sweep)
+{
+    if (sweep == NULL)
+    {
+        return;
+    }
+    freeGrid(sweep->windows[0]);
+    freeGrid(sweep->windows[1]);
+    free(sweep->wrap);
+    free(sweep->firstRow);
+    free(sweep->rowStart);
+    freePool(sweep->pool);
+    free(sweep);
+}
+
+/**
+ * Update the band of the window. In a cyclic grid the last row reads the updated first row
+ * below it, which is only known once the first band is updated: the halo row below the last
+ * band is set right before its last row is updated.
+ * @param sweep the buffers, with the band to update
+ */
+void updateBand(disk_sweep *sweep)
+{
+    heat_grid *window = sweep->window;
+    size_t rows = sweep->rows, m = window->m;
+    const size_t *rowStart = sweep->index->rowStart + sweep->first;
+    // The window has no sources in its halo rows
+    sweep->rowStart[0] = rowStart[0];
+    for (size_t i = 0; i <= rows; i++)
+    {
+        sweep->rowStart[i + 1] = rowStart[i];
+    }
+    sweep->rowStart[rows + 2] = rowStart[rows];
+    source_index index = {rows + 2, sweep->rowStart, sweep->index->cols,
+                          sweep->index->capacity};
+    window->n = rows + 2;
+    int wrapLast = sweep->last && sweep->is_cyclic >= TRUE;
+    size_t end = wrapLast ? rows : rows + 1;
+    updateRows(sweep->function, NULL, window, window, &index, sweep->is_cyclic, 1, end,
+               sweep->change);
+    if (wrapLast)
+    {
+        const double *first = sweep->first == 0 ? GRID_ROW(window, 1) : sweep->firstRow;
+        memcpy(GRID_ROW(window, rows + 1), first, m * sizeof(double));
+        updateRows(sweep->function, NULL, window, window, &index, sweep->is_cyclic, rows,
+                   rows + 1, sweep->change);
+    }
+    if (sweep->first == 0 && sweep->is_cyclic >= TRUE)
+    {
+        memcpy(sweep->firstRow, GRID_ROW(window, 1), m * sizeof(double));
+    }
+}
+
+/**
+ * Write the previous band out of the other window, then read the next band into it
+ * @param sweep the buffers, with the bands to move
+ */
+void moveBands(disk_sweep *sweep)
+{
+    heat_grid view = *sweep->moved;
+    view.data = GRID_ROW(sweep->moved, 1);
+    view.n = sweep->writeRows;
+    if (view.n > 0 && !writeDiskRows(sweep->grid, &view, sweep->writeFirst))
+    {
+        sweep->failed = TRUE;
+        return;
+    }
+    view.n = sweep->readRows;
+    if (view.n > 0 && !readDiskRows(sweep->grid, &view, sweep->readFirst))
+    {
+        sweep->failed = TRUE;
+    }
+}
+
+/**
+ * The part of one thread of the sweep of a band: update it, or move the other bands
+ * @param arg the buffers
+ * @param thread the thread
+ */
+void bandTask(void *arg, unsigned int thread)
+{
+    disk_sweep *sweep = (disk_sweep *) arg;
+    if (thread == 0)
+    {
+        updateBand(sweep);
+    }
+    else
+    {
+        moveBands(sweep);
+    }
+}
+
+/**
+ * Get the number of rows to read for a band: the band and the row below it, if any
+ * @param n height of the grid
+ * @param band rows of a band
+ * @param first first row of the band
+ * @return the number of rows
+ */
+size_t bandReadRows(size_t n, size_t band, size_t first)
+{
+    return first + band < n ? band + 1 : n - first;
+}
+
+/**
+ * One in place iteration of a disk grid, a band at a time (see outofcore.h)
+ * @param function function to apply
+ * @param grid the grid
+ * @param sweep the buffers of the grid
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param change the change of the iteration, updated
+ * @return 1 iff the file could be read and written
+ */
+int sweepDisk(diff_func function, disk_grid *grid, disk_sweep *sweep,
+              const source_index *index, int is_cyclic, residual *change)
+{
+    size_t n = grid->n, m = grid->m, band = sweep->band;
+    if (n == 0)
+    {
+        return TRUE;
+    }
+    sweep->function = function;
+    sweep->index = index;
+    sweep->is_cyclic = is_cyclic;
+    sweep->change = change;
+    sweep->grid = grid;
+    sweep->failed = FALSE;
+    // The first band, and in a cyclic grid the last row above it, before anything is written
+    heat_grid view = *sweep->windows[0];
+    view.data = GRID_ROW(sweep->windows[0], 1);
+    view.n = bandReadRows(n, band, 0);
+    heat_grid wrap = view;
+    wrap.data = sweep->wrap;
+    wrap.n = 1;
+    if (!readDiskRows(grid, &view, 0) || (is_cyclic >= TRUE && !readDiskRows(grid, &wrap, n - 1)))
+    {
+        return FALSE;
+    }
+    size_t count = 0;
+    for (size_t first = 0; first < n; first += band, count++)
+    {
+        heat_grid *window = sweep->windows[count % 2], *other = sweep->windows[(count + 1) % 2];
+        sweep->window = window;
+        sweep->first = first;
+        sweep->rows = first + band < n ? band : n - first;
+        sweep->last = first + band >= n;
+        double *top = GRID_ROW(window, 0);
+        if (first > 0)
+        {
+            memcpy(top, GRID_ROW(other, band), m * sizeof(double));
+        }
+        else if (is_cyclic >= TRUE)
+        {
+            memcpy(top, sweep->wrap, m * sizeof(double));
+        }
+        else
+        {
+            memset(top, 0, m * sizeof(double));
+        }
+        if (sweep->last && is_cyclic < TRUE)
+        {
+            memset(GRID_ROW(window, sweep->rows + 1), 0, m * sizeof(double));
+        }
+        sweep->moved = other;
+        sweep->writeFirst = first - (first > 0 ? band : 0);
+        sweep->writeRows = first > 0 ? band : 0;
+        sweep->readFirst = first + band;
+        sweep->readRows = sweep->last ? 0 : bandReadRows(n, band, first + band);
+        runPool(sweep->pool, bandTask, sweep);
+        if (sweep->failed)
+        {
+            return FALSE;
+        }
+    }
+    heat_grid *window = sweep->windows[(count + 1) % 2];
+    view = *window;
+    view.data = GRID_ROW(window, 1);
+    view.n = n - (count - 1) * band;
+    return writeDiskRows(grid, &view, (count - 1) * band);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file outofcore.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Grids kept in a file, swept a band of rows at a time
+ * @section DESCRIPTION
+ * A disk grid holds its rows (padded like allocGrid rows) in a file, so it can be bigger than
+ * the memory. An in place iteration streams it through two windows of band + 2 rows: the band
+ * and a halo row on each side. While a band is updated, a second thread writes the previous
+ * band back and reads the next one, so the file is read and written once per iteration and
+ * the disk works while the cells are computed.
+ */
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+#include <stdlib.h>
+#include "calculator.h"
+#include "kernel.h"
+
+// -------------------------- const definitions -------------------------
+/**
+ * Default number of rows of a band.
+ */
+#define DISK_BAND 256
+
+/**
+ * A grid in a file.
+ */
+typedef struct disk_grid
+{
+	int fd;
+	size_t n, m, stride;
+} disk_grid;
+
+/**
+ * Buffers and thread of the iterations of a disk grid.
+ */
+typedef struct disk_sweep disk_sweep;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Create a zero filled disk grid (the file is replaced, and kept when the grid is closed)
+ * @param path the file
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the grid, or NULL if the file could not be created
+ */
+disk_grid *createDiskGrid(const char *path, size_t n, size_t m);
+
+/**
+ * Close a disk grid
+ * @param grid the grid (may be NULL)
+ */
+void closeDiskGrid(disk_grid *grid);
+
+/**
+ * Read rows of a disk grid
+ * @param grid the grid
+ * @param rows where to read rows->n rows (with the width of the grid)
+ * @param first first row to read
+ * @return 1 iff the rows were read
+ */
+int readDiskRows(const disk_grid *grid, heat_grid *rows, size_t first);
+
+/**
+ * Write rows of a disk grid
+ * @param grid the grid
+ * @param rows the rows->n rows to write (with the width of the grid)
+ * @param first first row to write
+ * @return 1 iff the rows were written
+ */
+int writeDiskRows(disk_grid *grid, const heat_grid *rows, size_t first);
+
+/**
+ * Set the sources in a disk grid (they must be inside of it)
+ * @param grid the grid
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param band number of rows updated at a time
+ * @return 1 iff the grid could be updated
+ */
+int placeDiskSources(disk_grid *grid, const source_point *sources, size_t num_sources,
+                     size_t band);
+
+/**
+ * Allocate the buffers and the thread of the iterations of a disk grid
+ * @param grid the grid
+ * @param band number of rows of a band (at least 1)
+ * @return the buffers, or NULL if they could not be allocated
+ */
+disk_sweep *createDiskSweep(const disk_grid *grid, size_t band);
+
+/**
+ * Free the buffers and the thread of the iterations of a disk grid
+ * @param sweep the buffers (may be NULL)
+ */
+void freeDiskSweep(disk_sweep *sweep);
+
+/**
+ * One in place iteration (like the Gauss-Seidel scheme) of a disk grid, a band at a time.
+ * Every row reads the same values as in a whole grid, so the cells and the change are exactly
+ * those of an in memory iteration.
+ * @param function function to apply
+ * @param grid the grid
+ * @param sweep the buffers of the grid
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param change the change of the iteration, updated
+ * @return 1 iff the file could be read and written
+ */
+int sweepDisk(diff_func function, disk_grid *grid, disk_sweep *sweep,
+              const source_index *index, int is_cyclic, residual *change);
+
+#endif
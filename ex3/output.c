@@ -0,0 +1,367 @@
+/**
+ * @file output.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Buffered text and binary output of the grids.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "output.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define BUFFER_SIZE (1 << 20)
+/**
+ * Below 2^52 every double is a multiple of 1/2 at most, so the rounding of value * 10^precision
+ * to an integer can be decided exactly (see formatFixed).
+ */
+#define EXACT_LIMIT 4503599627370496.0
+#define WORD_BYTES 8
+#define HALF_WORD_BYTES 4
+// ------------------------------ structs -----------------------------
+
+/**
+ * The stream: the bytes not written yet are buffer[0 .. used).
+ */
+struct output_stream
+{
+    FILE *file;
+    output_format format;
+    char *buffer;
+    size_t used;
+    int failed;
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Set the default options: every grid, as text
+ * @param options the options
+ */
+void initOutputOptions(output_options *options)
+{
+    options->format = OUTPUT_TEXT;
+    options->final_only = FALSE;
+}
+
+/**
+ * Open an output stream
+ * @param file the file to write to, NULL for none until redirectOutput
+ * @param format format of the output
+ * @return the stream, or NULL if it could not be allocated
+ */
+output_stream *openOutput(FILE *file, output_format format)
+{
+    output_stream *stream = (output_stream *) malloc(sizeof(output_stream));
+    if (stream == NULL)
+    {
+        return NULL;
+    }
+    stream->buffer = (char *) malloc(BUFFER_SIZE);
+    if (stream->buffer == NULL)
+    {
+        free(stream);
+        return NULL;
+    }
+    stream->file = file;
+    stream->format = format;
+    stream->used = 0;
+    stream->failed = FALSE;
+    return stream;
+}
+
+/**
+ * Write the buffer to the file
+ * @param stream the stream
+ */
+void flushOutput(output_stream *stream)
+{
+    if (stream->used > 0 && fwrite(stream->buffer, 1, stream->used, stream->file) != stream->used)
+    {
+        stream->failed = TRUE;
+    }
+    stream->used = 0;
+}
+
+/**
+ * Make room in the buffer
+ * @param stream the stream
+ * @param size number of bytes needed (at most BUFFER_SIZE)
+ * @return where to write them
+ */
+char *reserveOutput(output_stream *stream, size_t size)
+{
+    if (stream->used + size > BUFFER_SIZE)
+    {
+        flushOutput(stream);
+    }
+    return stream->buffer + stream->used;
+}
+
+/**
+ * Format a number like printf("%.<precision>f").
+ * The digits are those of the integer nearest to |value| * 10^precision (ties to even, like
+ * printf). The product is rounded, but its error is exactly given by fma, and it is smaller
+ * than the distance of a rounded product to any other half integer, so it only decides ties.
+ * @param text where to write, at least FORMAT_LENGTH characters (not terminated)
+ * @param value the number
+ * @param precision digits after the point (at most MAX_PRECISION)
+ * @return the number of characters written
+ */
+size_t formatFixed(char *text, double value, int precision)
+{
+    static const double scales[MAX_PRECISION + 1] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+    };
+    double magnitude = fabs(value);
+    double scaled = magnitude * scales[precision];
+    if (!(scaled < EXACT_LIMIT))
+    {
+        // Too big for the fast path, or not finite
+        char buffer[FORMAT_LENGTH + 1];
+        int length = snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+        memcpy(text, buffer, (size_t) length);
+        return (size_t) length;
+    }
+    double error = fma(magnitude, scales[precision], -scaled);
+    double whole = floor(scaled);
+    double half = scaled - whole - 0.5;
+    uint64_t units = (uint64_t) whole;
+    if (half > 0 || (half == 0 && (error > 0 || (error == 0 && units % 2 == 1))))
+    {
+        units++;
+    }
+    size_t length = 0;
+    if (signbit(value))
+    {
+        text[length++] = '-';
+    }
+    char digits[FORMAT_LENGTH];
+    int count = 0;
+    do
+    {
+        digits[count++] = (char) ('0' + units % 10);
+        units /= 10;
+    } while (units > 0 || count <= precision);
+    for (int k = count - 1; k >= 0; k--)
+    {
+        text[length++] = digits[k];
+        if (k == precision && precision > 0)
+        {
+            text[length++] = '.';
+        }
+    }
+    return length;
+}
+
+/**
+ * Write bytes
+ * @param stream the stream
+ * @param bytes the bytes
+ * @param size number of bytes
+ */
+void writeBytes(output_stream *stream, const void *bytes, size_t size)
+{
+    const char *from = (const char *) bytes;
+    while (size > 0)
+    {
+        size_t chunk = size < BUFFER_SIZE ? size : BUFFER_SIZE;
+        memcpy(reserveOutput(stream, chunk), from, chunk);
+        stream->used += chunk;
+        from += chunk;
+        size -= chunk;
+    }
+}
+
+/**
+ * Write an unsigned integer, little-endian
+ * @param stream the stream
+ * @param word the integer
+ * @param bytes its size in bytes
+ */
+void writeWord(output_stream *stream, uint64_t word, int bytes)
+{
+    unsigned char *out = (unsigned char *) reserveOutput(stream, (size_t) bytes);
+    for (int k = 0; k < bytes; k++)
+    {
+        out[k] = (unsigned char) (word >> (8 * k));
+    }
+    stream->used += (size_t) bytes;
+}
+
+/**
+ * Write a double, little-endian
+ * @param stream the stream
+ * @param value the double
+ */
+void writeDouble(output_stream *stream, double value)
+{
+    uint64_t word;
+    memcpy(&word, &value, sizeof(word));
+    writeWord(stream, word, WORD_BYTES);
+}
+
+/**
+ * Tell if the doubles of this machine are stored little-endian
+ * @return 1 iff they are
+ */
+int isLittleEndian(void)
+{
+    uint64_t word = 1;
+    unsigned char first;
+    memcpy(&first, &word, 1);
+    return first == 1;
+}
+
+/**
+ * Write the header of a binary frame
+ * @param stream the stream
+ * @param diff the diff of the last calculation
+ * @param n height of the grid
+ * @param m width of the grid
+ */
+void writeFrameHeader(output_stream *stream, double diff, size_t n, size_t m)
+{
+    writeBytes(stream, FRAME_MAGIC, strlen(FRAME_MAGIC));
+    writeWord(stream, FRAME_VERSION, HALF_WORD_BYTES);
+    writeWord(stream, n, WORD_BYTES);
+    writeWord(stream, m, WORD_BYTES);
+    writeDouble(stream, diff);
+}
+
+/**
+ * Write rows of a grid as the cells of a binary frame
+ * @param stream the stream
+ * @param rows the rows
+ */
+void writeFrameRows(output_stream *stream, const heat_grid *rows)
+{
+    int little = isLittleEndian();
+    for (size_t i = 0; i < rows->n; i++)
+    {
+        const double *row = GRID_ROW(rows, i);
+        if (little)
+        {
+            writeBytes(stream, row, rows->m * sizeof(double));
+            continue;
+        }
+        for (size_t j = 0; j < rows->m; j++)
+        {
+            writeDouble(stream, row[j]);
+        }
+    }
+}
+
+/**
+ * Write rows of a grid as text: a line of "cell," per row
+ * @param stream the stream
+ * @param rows the rows
+ */
+void writeTextRows(output_stream *stream, const heat_grid *rows)
+{
+    for (size_t i = 0; i < rows->n; i++)
+    {
+        const double *row = GRID_ROW(rows, i);
+        for (size_t j = 0; j < rows->m; j++)
+        {
+            char *out = reserveOutput(stream, FORMAT_LENGTH + 1);
+            size_t length = formatFixed(out, row[j], CELL_PRECISION);
+            out[length] = ',';
+            stream->used += length + 1;
+        }
+        *reserveOutput(stream, 1) = '\n';
+        stream->used++;
+    }
+}
+
+/**
+ * Start a grid: the diff line (text) or the header of a frame (binary)
+ * @param stream the stream
+ * @param diff the diff of the last calculation
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return 1 iff everything written so far reached the file
+ */
+int beginGrid(output_stream *stream, double diff, size_t n, size_t m)
+{
+    if (stream->format == OUTPUT_BINARY)
+    {
+        writeFrameHeader(stream, diff, n, m);
+        return !stream->failed;
+    }
+    char *out = reserveOutput(stream, FORMAT_LENGTH + 1);
+    size_t length = formatFixed(out, diff, DIFF_PRECISION);
+    out[length] = '\n';
+    stream->used += length + 1;
+    return !stream->failed;
+}
+
+/**
+ * Write the next rows of the grid started by beginGrid
+ * @param stream the stream
+ * @param rows the rows
+ * @return 1 iff everything written so far reached the file
+ */
+int writeRows(output_stream *stream, const heat_grid *rows)
+{
+    if (stream->format == OUTPUT_BINARY)
+    {
+        writeFrameRows(stream, rows);
+    }
+    else
+    {
+        writeTextRows(stream, rows);
+    }
+    return !stream->failed;
+}
+
+/**
+ * Write a grid: the diff line then the rows (text), or a frame (binary)
+ * @param stream the stream
+ * @param diff the diff of the last calculation
+ * @param grid the grid
+ * @return 1 iff everything written so far reached the file
+ */
+int writeGrid(output_stream *stream, double diff, const heat_grid *grid)
+{
+    return beginGrid(stream, diff, grid->n, grid->m) && writeRows(stream, grid);
+}
+
+/**
+ * Flush a stream, then write to another file with the same buffer
+ * @param stream the stream
+ * @param file the file to write to, NULL for none until the next redirection
+ * @param format format of the output
+ * @return 1 iff everything written to the previous file reached it
+ */
+int redirectOutput(output_stream *stream, FILE *file, output_format format)
+{
+    flushOutput(stream);
+    int ok = !stream->failed && (stream->file == NULL || fflush(stream->file) == 0);
+    stream->file = file;
+    stream->format = format;
+    stream->failed = FALSE;
+    return ok;
+}
+
+/**
+ * Flush and close a stream (the file stays open)
+ * @param stream the stream (may be NULL)
+ * @return 1 iff everything written reached the file
+ */
+int closeOutput(output_stream *stream)
+{
+    if (stream == NULL)
+    {
+        return TRUE;
+    }
+    flushOutput(stream);
+    int ok = !stream->failed && (stream->file == NULL || fflush(stream->file) == 0);
+    free(stream->buffer);
+    free(stream);
+    return ok;
+}
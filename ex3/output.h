@@ -0,0 +1,130 @@
+/**
+ * @file output.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Buffered output of the grids
+ * @section DESCRIPTION
+ * The grids are written through one large buffer, as text (fixed precision, formatted without
+ * printf) or as binary frames. A binary frame is, all little-endian:
+ * the magic "HEAT", the uint32 version, the uint64 height n and width m, the float64 diff,
+ * then the n * m float64 cells row by row.
+ */
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "grid.h"
+
+// -------------------------- const definitions -------------------------
+/**
+ * Digits after the point of the cells and of the diff in the text output.
+ */
+#define CELL_PRECISION 4
+#define DIFF_PRECISION 6
+
+/**
+ * Magic and version of a binary frame.
+ */
+#define FRAME_MAGIC "HEAT"
+#define FRAME_VERSION 1
+
+/**
+ * Largest precision of formatFixed, and the longest text it writes.
+ */
+#define MAX_PRECISION 9
+#define FORMAT_LENGTH 352
+
+/**
+ * Format of the output.
+ */
+typedef enum
+{
+	OUTPUT_TEXT,
+	OUTPUT_BINARY
+} output_format;
+
+/**
+ * Options of the output: its format, and whether only the last grid is written.
+ */
+typedef struct
+{
+	output_format format;
+	int final_only;
+} output_options;
+
+/**
+ * An output stream.
+ */
+typedef struct output_stream output_stream;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Set the default options: every grid, as text
+ * @param options the options
+ */
+void initOutputOptions(output_options *options);
+
+/**
+ * Open an output stream
+ * @param file the file to write to, NULL for none until redirectOutput
+ * @param format format of the output
+ * @return the stream, or NULL if it could not be allocated
+ */
+output_stream *openOutput(FILE *file, output_format format);
+
+/**
+ * Start a grid: the diff line (text) or the header of a frame (binary).
+ * Its rows follow with writeRows, so a grid can be written a band at a time.
+ * @param stream the stream
+ * @param diff the diff of the last calculation
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return 1 iff everything written so far reached the file
+ */
+int beginGrid(output_stream *stream, double diff, size_t n, size_t m);
+
+/**
+ * Write the next rows of the grid started by beginGrid
+ * @param stream the stream
+ * @param rows the rows
+ * @return 1 iff everything written so far reached the file
+ */
+int writeRows(output_stream *stream, const heat_grid *rows);
+
+/**
+ * Write a grid: the diff line then the rows (text), or a frame (binary)
+ * @param stream the stream
+ * @param diff the diff of the last calculation
+ * @param grid the grid
+ * @return 1 iff everything written so far reached the file
+ */
+int writeGrid(output_stream *stream, double diff, const heat_grid *grid);
+
+/**
+ * Flush a stream, then write to another file with the same buffer (the previous file stays
+ * open)
+ * @param stream the stream
+ * @param file the file to write to, NULL for none until the next redirection
+ * @param format format of the output
+ * @return 1 iff everything written to the previous file reached it
+ */
+int redirectOutput(output_stream *stream, FILE *file, output_format format);
+
+/**
+ * Flush and close a stream (the file stays open)
+ * @param stream the stream (may be NULL)
+ * @return 1 iff everything written reached the file
+ */
+int closeOutput(output_stream *stream);
+
+/**
+ * Format a number like printf("%.<precision>f")
+ * @param text where to write, at least FORMAT_LENGTH characters (not terminated)
+ * @param value the number
+ * @param precision digits after the point (at most MAX_PRECISION)
+ * @return the number of characters written
+ */
+size_t formatFixed(char *text, double value, int precision);
+
+#endif
@@ -0,0 +1,310 @@
+/**
+ * @file parallel.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * A pool of pthreads which sleep between the tasks, and cancel flags behind a mutex.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _POSIX_C_SOURCE 200112L
+#include <stdlib.h>
+#include <pthread.h>
+#include "parallel.h"
+// ------------------------------ structs -----------------------------
+
+/**
+ * Argument of a worker thread.
+ */
+typedef struct
+{
+    thread_pool *pool;
+    unsigned int id;
+} worker;
+
+/**
+ * The pool. A task is published by bumping generation, running counts the workers which
+ * did not finish it yet.
+ */
+struct thread_pool
+{
+    unsigned int threads;
+    pthread_t *threadIds;
+    worker *workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    pthread_barrier_t barrier;
+    unsigned long generation;
+    unsigned int running;
+    unsigned long next;
+    int quit;
+    pool_task task;
+    void *arg;
+};
+
+/**
+ * A flag, read and written under its lock.
+ */
+struct cancel_flag
+{
+    pthread_mutex_t lock;
+    int raised;
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Main loop of a worker: wait for a task, run it, tell the pool
+ * @param arg the worker
+ * @return NULL
+ */
+void *workerLoop(void *arg)
+{
+    worker *self = (worker *) arg;
+    thread_pool *pool = self->pool;
+    unsigned long seen = 0;
+    while (1)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->quit)
+        {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->quit)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pool_task task = pool->task;
+        void *taskArg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(taskArg, self->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0)
+        {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * Start a pool
+ * @param threads number of threads, including the calling thread (at least 1)
+ * @return the pool, or NULL if it could not be created
+ */
+thread_pool *createPool(unsigned int threads)
+{
+    if (threads == 0)
+    {
+        return NULL;
+    }
+    thread_pool *pool = (thread_pool *) calloc(1, sizeof(thread_pool));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+    pool->threads = threads;
+    pool->threadIds = (pthread_t *) malloc(sizeof(pthread_t) * threads);
+    pool->workers = (worker *) malloc(sizeof(worker) * threads);
+    if (pool->threadIds == NULL || pool->workers == NULL)
+    {
+        free(pool->threadIds);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pthread_barrier_init(&pool->barrier, NULL, threads);
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        pool->workers[t].pool = pool;
+        pool->workers[t].id = t;
+        if (pthread_create(pool->threadIds + t, NULL, workerLoop, pool->workers + t) != 0)
+        {
+            pool->threads = t; // Only stop the threads that were started
+            freePool(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+/**
+ * Get the number of threads of a pool
+ * @param pool the pool (NULL is a pool of just the calling thread)
+ * @return the number of threads
+ */
+unsigned int poolSize(const thread_pool *pool)
+{
+    return pool == NULL ? 1 : pool->threads;
+}
+
+/**
+ * Run a task on every thread of the pool, and wait for all of them to finish
+ * @param pool the pool (NULL runs the task on the calling thread only)
+ * @param task the task
+ * @param arg argument given to the task
+ */
+void runPool(thread_pool *pool, pool_task task, void *arg)
+{
+    if (pool != NULL)
+    {
+        pool->next = 0;
+    }
+    if (pool == NULL || pool->threads == 1)
+    {
+        task(arg, 0);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->running = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running > 0)
+    {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Inside a task, wait until all the threads of the pool reach the barrier
+ * @param pool the pool (NULL returns at once)
+ */
+void poolBarrier(thread_pool *pool)
+{
+    if (pool != NULL && pool->threads > 1)
+    {
+        pthread_barrier_wait(&pool->barrier);
+    }
+}
+
+/**
+ * Inside a task, take the next item of the run
+ * @param pool the pool (not NULL)
+ * @return the item
+ */
+unsigned long poolNext(thread_pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    unsigned long item = pool->next++;
+    pthread_mutex_unlock(&pool->lock);
+    return item;
+}
+
+/**
+ * Stop the threads and free the pool (NULL is ignored)
+ * @param pool the pool
+ */
+void freePool(thread_pool *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned int t = 1; t < pool->threads; t++)
+    {
+        pthread_join(pool->threadIds[t], NULL);
+    }
+    pthread_barrier_destroy(&pool->barrier);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threadIds);
+    free(pool->workers);
+    free(pool);
+}
+
+/**
+ * Create a flag, lowered
+ * @return the flag, or NULL if it could not be created
+ */
+cancel_flag *createCancelFlag(void)
+{
+    cancel_flag *flag = (cancel_flag *) malloc(sizeof(cancel_flag));
+    if (flag == NULL)
+    {
+        return NULL;
+    }
+    if (pthread_mutex_init(&flag->lock, NULL) != 0)
+    {
+        free(flag);
+        return NULL;
+    }
+    flag->raised = 0;
+    return flag;
+}
+
+/**
+ * Set a flag
+ * @param flag the flag
+ * @param raised 1 to raise it, 0 to lower it
+ */
+void setCancelFlag(cancel_flag *flag, int raised)
+{
+    pthread_mutex_lock(&flag->lock);
+    flag->raised = raised;
+    pthread_mutex_unlock(&flag->lock);
+}
+
+/**
+ * Raise a flag (from any thread)
+ * @param flag the flag
+ */
+void raiseCancelFlag(cancel_flag *flag)
+{
+    setCancelFlag(flag, 1);
+}
+
+/**
+ * Lower a flag, to use it again
+ * @param flag the flag
+ */
+void clearCancelFlag(cancel_flag *flag)
+{
+    setCancelFlag(flag, 0);
+}
+
+/**
+ * Tell if a flag is raised (from any thread)
+ * @param flag the flag
+ * @return 1 iff it is raised
+ */
+int isCancelled(cancel_flag *flag)
+{
+    pthread_mutex_lock(&flag->lock);
+    int raised = flag->raised;
+    pthread_mutex_unlock(&flag->lock);
+    return raised;
+}
+
+/**
+ * Free a flag (NULL is ignored)
+ * @param flag the flag
+ */
+void freeCancelFlag(cancel_flag *flag)
+{
+    if (flag == NULL)
+    {
+        return;
+    }
+    pthread_mutex_destroy(&flag->lock);
+    free(flag);
+}
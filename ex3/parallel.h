@@ -0,0 +1,102 @@
+/**
+ * @file parallel.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief A fixed size pool of worker threads
+ * @section DESCRIPTION
+ * The pool runs the same task on all of its threads (the calling thread is thread 0) and
+ * waits for them. Inside a task the threads can wait for each other with poolBarrier.
+ * A cancel flag is raised by any thread, and read by the others, to stop a task.
+ */
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/**
+ * A pool of threads.
+ */
+typedef struct thread_pool thread_pool;
+
+/**
+ * A flag any thread may raise.
+ */
+typedef struct cancel_flag cancel_flag;
+
+/**
+ * A task run by every thread of a pool.
+ */
+typedef void (*pool_task)(void *arg, unsigned int thread);
+
+/**
+ * Start a pool
+ * @param threads number of threads, including the calling thread (at least 1)
+ * @return the pool, or NULL if it could not be created
+ */
+thread_pool *createPool(unsigned int threads);
+
+/**
+ * Get the number of threads of a pool
+ * @param pool the pool (NULL is a pool of just the calling thread)
+ * @return the number of threads
+ */
+unsigned int poolSize(const thread_pool *pool);
+
+/**
+ * Run a task on every thread of the pool, and wait for all of them to finish
+ * @param pool the pool (NULL runs the task on the calling thread only)
+ * @param task the task
+ * @param arg argument given to the task
+ */
+void runPool(thread_pool *pool, pool_task task, void *arg);
+
+/**
+ * Inside a task, wait until all the threads of the pool reach the barrier
+ * @param pool the pool (NULL returns at once)
+ */
+void poolBarrier(thread_pool *pool);
+
+/**
+ * Inside a task, take the next item of the run, so the threads share items of different
+ * costs as they go. Every run of the pool hands out 0, 1, 2, ... in turn.
+ * @param pool the pool (not NULL)
+ * @return the item
+ */
+unsigned long poolNext(thread_pool *pool);
+
+/**
+ * Stop the threads and free the pool (NULL is ignored)
+ * @param pool the pool
+ */
+void freePool(thread_pool *pool);
+
+/**
+ * Create a flag, lowered
+ * @return the flag, or NULL if it could not be created
+ */
+cancel_flag *createCancelFlag(void);
+
+/**
+ * Raise a flag (from any thread)
+ * @param flag the flag
+ */
+void raiseCancelFlag(cancel_flag *flag);
+
+/**
+ * Lower a flag, to use it again
+ * @param flag the flag
+ */
+void clearCancelFlag(cancel_flag *flag);
+
+/**
+ * Tell if a flag is raised (from any thread)
+ * @param flag the flag
+ * @return 1 iff it is raised
+ */
+int isCancelled(cancel_flag *flag);
+
+/**
+ * Free a flag (NULL is ignored)
+ * @param flag the flag
+ */
+void freeCancelFlag(cancel_flag *flag);
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file profile.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Timers and throughput counters of the runs, written as JSON.
+ */
+
+// ------------------------------ includes ------------------------------
+#define _POSIX_C_SOURCE 200112L
+#include <string.h>
+#include <time.h>
+#include "profile.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define NANOSECONDS 1e-9
+#define GIGA 1e9
+#define PHASE_FORMAT "%s\"%s\": %.9g"
+#define PROFILE_FORMAT "}, \"total\": %.9g,\n" \
+                       " \"sweeps\": {\"count\": %lu, \"seconds\": %.9g, \"min\": %.9g, " \
+                       "\"mean\": %.9g, \"max\": %.9g},\n" \
+                       " \"cells\": %.17g, \"cells_per_second\": %.9g,\n" \
+                       " \"flops\": %.17g, \"gflops\": %.9g,\n" \
+                       " \"bytes\": %.17g, \"bytes_per_second\": %.9g"
+#define NODES_START ",\n \"nodes\": ["
+#define NODE_FORMAT "%s{\"node\": %u, \"bytes\": %.17g, \"bytes_per_second\": %.9g}"
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Read the clock of the profiles
+ * @return seconds since a fixed time
+ */
+double profileClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * NANOSECONDS;
+}
+
+/**
+ * Clear a profile
+ * @param profile the profile
+ */
+void initProfile(heat_profile *profile)
+{
+    memset(profile, 0, sizeof(heat_profile));
+}
+
+/**
+ * Start a phase
+ * @param profile the profile, NULL for none
+ * @return the time, 0 without a profile
+ */
+double startPhase(const heat_profile *profile)
+{
+    return profile != NULL ? profileClock() : 0;
+}
+
+/**
+ * End a phase: add its time to the profile
+ * @param profile the profile, NULL for none
+ * @param phase the phase
+ * @param start the time of startPhase
+ * @return the time, to start the next phase, 0 without a profile
+ */
+double endPhase(heat_profile *profile, profile_phase phase, double start)
+{
+    if (profile == NULL)
+    {
+        return 0;
+    }
+    double now = profileClock();
+    profile->phases[phase] += now - start;
+    return now;
+}
+
+/**
+ * Add sweeps to a profile
+ * @param profile the profile
+ * @param sweeps number of sweeps (at least 1)
+ * @param seconds their time
+ * @param cells cells updated by a sweep
+ * @param cellFlops floating point operations per cell updated
+ * @param cellBytes bytes read or written per cell updated
+ */
+void addSweeps(heat_profile *profile, unsigned long sweeps, double seconds, double cells,
+               double cellFlops, double cellBytes)
+{
+    double each = seconds / (double) sweeps;
+    if (profile->sweeps == 0 || each < profile->min_sweep)
+    {
+        profile->min_sweep = each;
+    }
+    if (profile->sweeps == 0 || each > profile->max_sweep)
+    {
+        profile->max_sweep = each;
+    }
+    profile->sweeps += sweeps;
+    profile->sweep_time += seconds;
+    double updated = cells * (double) sweeps;
+    profile->cells += updated;
+    profile->flops += updated * cellFlops;
+    profile->bytes += updated * cellBytes;
+}
+
+/**
+ * Add the bytes moved by the sweeps of a thread to its node
+ * @param profile the profile
+ * @param node the node (below PROFILE_NODES)
+ * @param bytes the bytes
+ */
+void addNodeBytes(heat_profile *profile, unsigned int node, double bytes)
+{
+    profile->node_bytes[node] += bytes;
+}
+
+/**
+ * Divide, with 0 for a quotient by 0 (which has no JSON number)
+ * @param amount the amount
+ * @param seconds the time
+ * @return the rate
+ */
+double getRate(double amount, double seconds)
+{
+    return seconds > 0 ? amount / seconds : 0;
+}
+
+/**
+ * Write a profile as a JSON object: the phases, the sweeps and the throughputs, and those of
+ * the nodes which moved bytes
+ * @param profile the profile
+ * @param file the file
+ * @return 1 iff it was written
+ */
+int writeProfile(const heat_profile *profile, FILE *file)
+{
+    static const char *names[PHASE_COUNT] = {"parse", "setup", "solve", "output"};
+    double total = 0;
+    int written = fputs("{\"phases\": {", file) >= 0;
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        written = written && fprintf(file, PHASE_FORMAT, phase > 0 ? ", " : "", names[phase],
+                                     profile->phases[phase]) > 0;
+        total += profile->phases[phase];
+    }
+    double time = profile->sweep_time;
+    written = written && fprintf(file, PROFILE_FORMAT, total, profile->sweeps, time,
+                                 profile->min_sweep, getRate(time, (double) profile->sweeps),
+                                 profile->max_sweep, profile->cells,
+                                 getRate(profile->cells, time), profile->flops,
+                                 getRate(profile->flops, time) / GIGA, profile->bytes,
+                                 getRate(profile->bytes, time)) > 0;
+    unsigned int listed = 0;
+    for (unsigned int node = 0; node < PROFILE_NODES; node++)
+    {
+        if (profile->node_bytes[node] > 0)
+        {
+            written = written && fprintf(file, NODE_FORMAT, listed++ > 0 ? ", " : NODES_START,
+                                         node, profile->node_bytes[node],
+                                         getRate(profile->node_bytes[node], time)) > 0;
+        }
+    }
+    if (listed > 0)
+    {
+        written = written && fputs("]", file) >= 0;
+    }
+    written = written && fputs("}\n", file) >= 0;
+    return written ? TRUE : FALSE;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file profile.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Timers and throughput counters of the heat calculator
+ * @section DESCRIPTION
+ * A profile adds up the wall time of the phases of a run (reading the input, setting up the
+ * grid, solving, writing the output) and of the sweeps of the calculations, with the cells
+ * they updated. The floating point operations and the bytes moved are estimates: a number per
+ * cell updated, given by the calculation (see calculator.h). A calculation without a profile
+ * reads no clock.
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+// -------------------------- const definitions -------------------------
+/**
+ * Floating point operations of the new value of a cell by heat_eqn: 3 additions and a
+ * multiplication.
+ */
+#define HEAT_CELL_FLOPS 4
+/**
+ * Floating point operations of the change of a cell: a subtraction and an addition.
+ */
+#define CHANGE_CELL_FLOPS 2
+/**
+ * Number of memory nodes a profile tells apart (see numa.h).
+ */
+#define PROFILE_NODES 16
+
+/**
+ * The phases of a run.
+ */
+typedef enum
+{
+	PHASE_PARSE,
+	PHASE_SETUP,
+	PHASE_SOLVE,
+	PHASE_OUTPUT,
+	PHASE_COUNT
+} profile_phase;
+
+/**
+ * A profile. phases holds the seconds of every phase. sweeps is the number of sweeps timed,
+ * sweep_time their seconds, and min_sweep and max_sweep the shortest and longest of them (a
+ * band of sweeps run together counts as that many sweeps of the same time). cells, flops and
+ * bytes are the cells updated by the sweeps, and the estimates of their operations and bytes.
+ * node_bytes splits the bytes between the nodes of the threads, when they are pinned.
+ */
+typedef struct
+{
+	double phases[PHASE_COUNT];
+	unsigned long sweeps;
+	double sweep_time, min_sweep, max_sweep;
+	double cells, flops, bytes;
+	double node_bytes[PROFILE_NODES];
+} heat_profile;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Read the clock of the profiles
+ * @return seconds since a fixed time
+ */
+double profileClock(void);
+
+/**
+ * Clear a profile
+ * @param profile the profile
+ */
+void initProfile(heat_profile *profile);
+
+/**
+ * Start a phase
+ * @param profile the profile, NULL for none
+ * @return the time, 0 without a profile
+ */
+double startPhase(const heat_profile *profile);
+
+/**
+ * End a phase: add its time to the profile
+ * @param profile the profile, NULL for none
+ * @param phase the phase
+ * @param start the time of startPhase
+ * @return the time, to start the next phase, 0 without a profile
+ */
+double endPhase(heat_profile *profile, profile_phase phase, double start);
+
+/**
+ * Add sweeps to a profile
+ * @param profile the profile
+ * @param sweeps number of sweeps (at least 1)
+ * @param seconds their time
+ * @param cells cells updated by a sweep
+ * @param cellFlops floating point operations per cell updated
+ * @param cellBytes bytes read or written per cell updated
+ */
+void addSweeps(heat_profile *profile, unsigned long sweeps, double seconds, double cells,
+               double cellFlops, double cellBytes);
+
+/**
+ * Add the bytes moved by the sweeps of a thread to its node
+ * @param profile the profile
+ * @param node the node (below PROFILE_NODES)
+ * @param bytes the bytes
+ */
+void addNodeBytes(heat_profile *profile, unsigned int node, double bytes);
+
+/**
+ * Write a profile as a JSON object: the phases, the sweeps and the throughputs, and those of
+ * the nodes which moved bytes
+ * @param profile the profile
+ * @param file the file
+ * @return 1 iff it was written
+ */
+int writeProfile(const heat_profile *profile, FILE *file);
+
+#endif
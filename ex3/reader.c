@@ -7,77 +7,636 @@
  */
 
 // ------------------------------ includes ------------------------------
+#define _POSIX_C_SOURCE 200112L
+#include <dirent.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "calculator.h"
+#include "checkpoint.h"
+#include "input.h"
+#include "outofcore.h"
+#include "output.h"
+#include "parallel.h"
+#include "profile.h"
+#include "stencil.h"
 #include "heat_eqn.h"
 // -------------------------- const definitions -------------------------
 #define ERROR_MSG "error"
-#define CORRECT_USAGE "correct usage is <filename>"
-#define SEPARATOR "----\n"
-#define NON_SOURCES_LINES 6
+#define CORRECT_USAGE "correct usage is <filename>, " RESTART_FLAG " <snapshot> or " \
+                      BATCH_FLAG " <manifest or directory> <output directory> [workers]"
+#define RESTART_FLAG "--restart"
+#define BATCH_FLAG "--batch"
+#define JOB_ERROR_FORMAT "error: %s\n"
+#define OUTPUT_SUFFIX ".out"
+#define LINE_ERROR_FORMAT "error: line %lu: %s\n"
+#define SEPARATOR_LENGTH 4
+#define SOURCES_CAPACITY 64
+/**
+ * Optional "name=value" lines after the parameters
+ */
+#define OPTION_SEPARATOR '='
+#define OPTION_LENGTH 32
+#define VALUE_LENGTH SNAPSHOT_PATH_LENGTH
+#define THREADS_OPTION "threads"
+#define PROCESSES_OPTION "processes"
+#define SCHEME_OPTION "scheme"
+#define GAUSS_SEIDEL_NAME "gauss-seidel"
+#define JACOBI_NAME "jacobi"
+#define RED_BLACK_NAME "red-black"
+#define MULTIGRID_NAME "multigrid"
+#define SIMD_OPTION "simd"
+#define CHECK_SIMD_OPTION "check_simd"
+#define PRECISION_OPTION "precision"
+#define CHECK_PRECISION_OPTION "check_precision"
+#define SPARSE_OPTION "sparse"
+#define NUMA_OPTION "numa"
+#define STENCIL_OPTION "stencil"
+#define HEAT_NAME "heat"
+#define NINE_POINT_NAME "nine-point"
+#define ANISOTROPY_OPTION "anisotropy"
+#define STENCIL_POINT_OPTION "stencil_point"
+#define DRIFT_FORMAT "precision drift: cells %g, diff %g (%lu iterations, %lu in double)\n"
+#define TILE_OPTION "tile"
+#define NORM_OPTION "norm"
+#define CHECK_EVERY_OPTION "check_every"
+#define OUTPUT_OPTION "output"
+#define TEXT_NAME "text"
+#define BINARY_NAME "binary"
+#define PRINT_OPTION "print"
+#define ALL_NAME "all"
+#define FINAL_NAME "final"
+#define CHECKPOINT_OPTION "checkpoint"
+#define CHECKPOINT_EVERY_OPTION "checkpoint_every"
+#define DEFAULT_CHECKPOINT_EVERY 1000
+#define OUT_OF_CORE_OPTION "out_of_core"
+#define BAND_OPTION "band"
+#define PROFILE_OPTION "profile"
+#define TRUE 1
+#define FALSE 0
+// ------------------------------ structs -----------------------------
+
+/**
+ * Content of an input file, or of a snapshot (then the sources are in the snapshot).
+ * checkpoint is the file of the checkpoints, empty for none. outOfCore is the file which holds
+ * the grid instead of the memory, empty for none. drift is the drift of the last calculation in
+ * a lower precision, when it is checked. profile is the file the timers of the run are written
+ * to as JSON, empty for none.
+ */
+typedef struct
+{
+    int n, m;
+    source_point *sources;
+    size_t sourcesNumber, capacity;
+    double terminate;
+    int n_iter, isCyclic;
+    calc_options options;
+    output_options output;
+    char checkpoint[SNAPSHOT_PATH_LENGTH];
+    char outOfCore[SNAPSHOT_PATH_LENGTH];
+    heat_snapshot *snapshot;
+    precision_drift drift;
+    char profile[SNAPSHOT_PATH_LENGTH];
+    heat_profile timers;
+} heat_input;
+
+/**
+ * Buffers of a worker of a batch, kept from a job to the next: the free grids, and an output
+ * stream. failed counts the jobs of the worker which failed.
+ */
+typedef struct
+{
+    grid_pool grids;
+    output_stream *output;
+    unsigned long failed;
+} batch_worker;
+
+/**
+ * A batch: the input files, the directory of their outputs and the workers.
+ */
+typedef struct
+{
+    char **inputs;
+    size_t count;
+    const char *outputDir;
+    thread_pool *pool;
+    batch_worker *workers;
+} heat_batch;
+
 // ------------------------------ functions -----------------------------
 
 /**
  * free all allocated memory
  * @param grid grid to free
+ * @param content content of the input (with the sources), or of the snapshot
+ */
+void freeAll(heat_grid *grid, heat_input *content)
+{
+    if (content->snapshot != NULL)
+    {
+        closeSnapshot(content->snapshot);
+        return;
+    }
+    free(content->sources);
+    freeGrid(grid);
+}
+
+/**
+ * Report a malformed line of the file
+ * @param input the file, at the malformed line
+ * @param reason what is wrong with the line
+ * @return 0, to be returned by the parser
+ */
+int reportLine(const input_file *input, const char *reason)
+{
+    fprintf(stderr, LINE_ERROR_FORMAT, input->line, reason);
+    return FALSE;
+}
+
+/**
+ * Get the next line of the file which is not blank
+ * @param input the file
+ * @param line the line, without its leading blanks
+ * @return 1 iff there was such a line left
+ */
+int nextContentLine(input_file *input, input_line *line)
+{
+    while (nextLine(input, line))
+    {
+        if (!skipBlanks(line))
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * Tell if a line is a separator: only dashes, at least SEPARATOR_LENGTH of them
+ * @param line the line, without its leading blanks
+ * @return 1 iff it is a separator
+ */
+int isSeparator(input_line line)
+{
+    const char *p = line.begin;
+    while (p < line.end && *p == '-')
+    {
+        p++;
+    }
+    return p - line.begin >= SEPARATOR_LENGTH && skipBlanks(&(input_line) {p, line.end});
+}
+
+/**
+ * Read the next line, which must be a separator
+ * @param input the file
+ * @return 1 iff it was a separator
+ */
+int getSeparator(input_file *input)
+{
+    input_line line;
+    if (!nextContentLine(input, &line))
+    {
+        return reportLine(input, "missing separator");
+    }
+    return isSeparator(line) ? TRUE : reportLine(input, "expected a separator");
+}
+
+/**
+ * Read an integer line of the file
+ * @param input the file
+ * @param min smallest valid value
+ * @param value the integer
+ * @return 1 iff the line holds a valid integer
+ */
+int getIntegerLine(input_file *input, long min, int *value)
+{
+    input_line line;
+    long number;
+    if (!nextContentLine(input, &line))
+    {
+        return reportLine(input, "missing parameter");
+    }
+    if (!parseInteger(&line, &number) || !skipBlanks(&line) || number < min
+        || number > INT_MAX)
+    {
+        return reportLine(input, "expected an integer");
+    }
+    *value = (int) number;
+    return TRUE;
+}
+
+/**
+ * Read the size line of the file: "n, m"
+ * @param input the file
+ * @param content the content to fill
+ * @return 1 iff the line is valid
+ */
+int getSize(input_file *input, heat_input *content)
+{
+    input_line line;
+    long n, m;
+    if (!nextContentLine(input, &line))
+    {
+        return reportLine(input, "missing grid size");
+    }
+    if (!parseInteger(&line, &n) || !skipChar(&line, ',') || !parseInteger(&line, &m)
+        || !skipBlanks(&line) || n < 1 || m < 1 || n > INT_MAX || m > INT_MAX)
+    {
+        return reportLine(input, "expected the grid size \"n, m\"");
+    }
+    content->n = (int) n;
+    content->m = (int) m;
+    return TRUE;
+}
+
+/**
+ * Add a source to the content, growing the list when it is full
+ * @param content the content
+ * @param source the source
+ * @return 1 iff the list could grow
+ */
+int addSource(heat_input *content, source_point source)
+{
+    if (content->sourcesNumber == content->capacity)
+    {
+        size_t capacity = content->capacity > 0 ? 2 * content->capacity : SOURCES_CAPACITY;
+        source_point *sources = (source_point *) realloc(content->sources,
+                                                         sizeof(source_point) * capacity);
+        if (sources == NULL)
+        {
+            return FALSE;
+        }
+        content->sources = sources;
+        content->capacity = capacity;
+    }
+    content->sources[content->sourcesNumber++] = source;
+    return TRUE;
+}
+
+/**
+ * Read the sources of the file: "x, y, value" lines up to a separator
+ * @param input the file, after the first separator
+ * @param content the content to fill
+ * @return 1 iff all the lines are valid
+ */
+int getSources(input_file *input, heat_input *content)
+{
+    input_line line;
+    while (nextContentLine(input, &line))
+    {
+        if (isSeparator(line))
+        {
+            return TRUE;
+        }
+        long x, y;
+        source_point source;
+        if (!parseInteger(&line, &x) || !skipChar(&line, ',') || !parseInteger(&line, &y)
+            || !skipChar(&line, ',') || !parseReal(&line, &source.value) || !skipBlanks(&line))
+        {
+            return reportLine(input, "expected a source \"x, y, value\"");
+        }
+        if (x < 0 || y < 0 || x >= content->n || y >= content->m)
+        {
+            return reportLine(input, "source outside of the grid");
+        }
+        source.x = (int) x;
+        source.y = (int) y;
+        if (!addSource(content, source))
+        {
+            return reportLine(input, "out of memory");
+        }
+    }
+    return reportLine(input, "missing separator");
+}
+
+/**
+ * Apply an option line of the file
+ * @param name name of the option
+ * @param value value of the option
  * @param n height of the grid
- * @param sourcesList list pf sources
+ * @param m width of the grid
+ * @param options the options to update
+ * @return 1 iff the option is known and its value is valid
  */
-void freeAll(double **grid, int n, source_point *sourcesList)
+int parseOption(const char *name, const char *value, int n, int m, calc_options *options)
 {
-    free(sourcesList);
-    for (int j = 0; j < n; j++)
+    if (strcmp(name, THREADS_OPTION) == 0)
     {
-        free(grid[j]);
+        char *end;
+        long threads = strtol(value, &end, 10);
+        if (*end != '\0' || threads < 1 || (unsigned long) threads > UINT_MAX)
+        {
+            return FALSE;
+        }
+        options->threads = (unsigned int) threads;
+        return TRUE;
     }
-    free(grid);
+    if (strcmp(name, PROCESSES_OPTION) == 0)
+    {
+        char *end;
+        long processes = strtol(value, &end, 10);
+        if (*end != '\0' || processes < 1 || (unsigned long) processes > UINT_MAX)
+        {
+            return FALSE;
+        }
+        options->processes = (unsigned int) processes;
+        return TRUE;
+    }
+    if (strcmp(name, TILE_OPTION) == 0)
+    {
+        char *end;
+        long tile = strtol(value, &end, 10);
+        // At most the height of a grid (the calculator runs no deeper bands)
+        if (*end != '\0' || tile < 0 || tile > INT_MAX)
+        {
+            return FALSE;
+        }
+        options->tile = (size_t) tile;
+        return TRUE;
+    }
+    if (strcmp(name, CHECK_EVERY_OPTION) == 0)
+    {
+        char *end;
+        long every = strtol(value, &end, 10);
+        if (*end != '\0' || every < 1 || (unsigned long) every > UINT_MAX)
+        {
+            return FALSE;
+        }
+        options->check_every = (unsigned int) every;
+        return TRUE;
+    }
+    if (strcmp(name, BAND_OPTION) == 0)
+    {
+        char *end;
+        long band = strtol(value, &end, 10);
+        if (*end != '\0' || band < 1)
+        {
+            return FALSE;
+        }
+        options->band = (size_t) band;
+        return TRUE;
+    }
+    if (strcmp(name, CHECKPOINT_EVERY_OPTION) == 0)
+    {
+        char *end;
+        long every = strtol(value, &end, 10);
+        if (*end != '\0' || every < 1 || (unsigned long) every > UINT_MAX)
+        {
+            return FALSE;
+        }
+        options->checkpoint_every = (unsigned int) every;
+        return TRUE;
+    }
+    if (strcmp(name, SCHEME_OPTION) == 0)
+    {
+        if (strcmp(value, GAUSS_SEIDEL_NAME) == 0)
+        {
+            options->scheme = SCHEME_GAUSS_SEIDEL;
+        }
+        else if (strcmp(value, JACOBI_NAME) == 0)
+        {
+            options->scheme = SCHEME_JACOBI;
+        }
+        else if (strcmp(value, RED_BLACK_NAME) == 0)
+        {
+            options->scheme = SCHEME_RED_BLACK;
+        }
+        else if (strcmp(value, MULTIGRID_NAME) == 0)
+        {
+            options->scheme = SCHEME_MULTIGRID;
+        }
+        else
+        {
+            return FALSE;
+        }
+        return TRUE;
+    }
+    if (strcmp(name, SIMD_OPTION) == 0)
+    {
+        const char *names[] = {"auto", "scalar", "sse2", "avx2", "avx512"};
+        for (int level = SIMD_AUTO; level <= SIMD_AVX512; level++)
+        {
+            if (strcmp(value, names[level]) == 0)
+            {
+                options->simd = (simd_level) level;
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+    if (strcmp(name, NORM_OPTION) == 0)
+    {
+        const char *names[] = {"sum", "l1", "l2", "linf"};
+        for (int norm = NORM_SUM; norm <= NORM_LINF; norm++)
+        {
+            if (strcmp(value, names[norm]) == 0)
+            {
+                options->norm = (convergence_norm) norm;
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+    if (strcmp(name, CHECK_SIMD_OPTION) == 0)
+    {
+        options->check_simd = strcmp(value, "0") != 0;
+        return TRUE;
+    }
+    if (strcmp(name, PRECISION_OPTION) == 0)
+    {
+        const char *names[] = {"double", "float", "mixed", "kahan"};
+        for (int precision = PRECISION_DOUBLE; precision <= PRECISION_KAHAN; precision++)
+        {
+            if (strcmp(value, names[precision]) == 0)
+            {
+                options->precision = (precision_mode) precision;
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+    if (strcmp(name, CHECK_PRECISION_OPTION) == 0)
+    {
+        options->check_precision = strcmp(value, "0") != 0;
+        return TRUE;
+    }
+    if (strcmp(name, SPARSE_OPTION) == 0)
+    {
+        options->sparse = strcmp(value, "0") != 0;
+        return TRUE;
+    }
+    if (strcmp(name, NUMA_OPTION) == 0)
+    {
+        options->numa = strcmp(value, "0") != 0;
+        return TRUE;
+    }
+    if (strcmp(name, STENCIL_OPTION) == 0)
+    {
+        if (strcmp(value, HEAT_NAME) == 0)
+        {
+            heatStencil(&options->stencil);
+            return TRUE;
+        }
+        if (strcmp(value, NINE_POINT_NAME) == 0)
+        {
+            ninePointStencil(&options->stencil);
+            return TRUE;
+        }
+        return FALSE;
+    }
+    if (strcmp(name, ANISOTROPY_OPTION) == 0)
+    {
+        char *end;
+        double ratio = strtod(value, &end);
+        if (*end != '\0' || !(ratio > 0))
+        {
+            return FALSE;
+        }
+        anisotropicStencil(&options->stencil, ratio);
+        return TRUE;
+    }
+    if (strcmp(name, STENCIL_POINT_OPTION) == 0)
+    {
+        input_line line = {value, value + strlen(value)};
+        long di, dj;
+        double weight;
+        // An offset of the whole grid or more does not reach a cell of its rows or columns
+        if (!parseInteger(&line, &di) || !skipChar(&line, ',') || !parseInteger(&line, &dj)
+            || !skipChar(&line, ',') || !parseReal(&line, &weight) || !skipBlanks(&line)
+            || di <= -n || di >= n || dj <= -m || dj >= m)
+        {
+            return FALSE;
+        }
+        return addStencilPoint(&options->stencil, (int) di, (int) dj, weight);
+    }
+    return FALSE;
 }
 
 /**
- * Get number of line in the file
- * @param file file
- * @return number of line
+ * Apply an output option line of the file
+ * @param name name of the option
+ * @param value value of the option
+ * @param output the output options to update
+ * @return 1 iff the option is an output option and its value is valid
  */
-int getLinesNumber(FILE *file)
+int parseOutputOption(const char *name, const char *value, output_options *output)
 {
-    int linesNumber = 0;
-    for (char c = (char) getc(file); c != EOF; c = (char) getc(file))
+    if (strcmp(name, OUTPUT_OPTION) == 0)
+    {
+        if (strcmp(value, TEXT_NAME) == 0 || strcmp(value, BINARY_NAME) == 0)
+        {
+            output->format = strcmp(value, TEXT_NAME) == 0 ? OUTPUT_TEXT : OUTPUT_BINARY;
+            return TRUE;
+        }
+        return FALSE;
+    }
+    if (strcmp(name, PRINT_OPTION) == 0)
     {
-        if (c == '\n')
+        if (strcmp(value, ALL_NAME) == 0 || strcmp(value, FINAL_NAME) == 0)
         {
-            linesNumber++;
+            output->final_only = strcmp(value, FINAL_NAME) == 0;
+            return TRUE;
         }
+        return FALSE;
     }
-    rewind(file);
-    return linesNumber + 1;
+    return FALSE;
 }
 
 /**
- * Get the sources list from the file (suppose we already read the first section)
- * @param sourcesNumber number of sources in the file
- * @param file file
- * @return a list of sources objects
+ * Read the option lines at the end of the file
+ * @param input the file
+ * @param content the content whose options are updated
+ * @return 1 iff all the options are valid
  */
-source_point *getSourcesList(int sourcesNumber, FILE *file)
+int getOptions(input_file *input, heat_input *content)
 {
-    source_point *sourcesList = (source_point *) malloc(sizeof(source_point) * sourcesNumber);
-    if (sourcesList == NULL)
+    input_line line;
+    initOptions(&content->options);
+    initOutputOptions(&content->output);
+    while (nextContentLine(input, &line))
     {
-        fprintf(stderr, ERROR_MSG);
-        fclose(file);
-        exit(1);
+        char name[OPTION_LENGTH], value[VALUE_LENGTH];
+        const char *separator = (const char *) memchr(line.begin, OPTION_SEPARATOR,
+                                                      (size_t) (line.end - line.begin));
+        const char *end = line.end;
+        while (end[-1] == ' ' || end[-1] == '\t')
+        {
+            end--;
+        }
+        if (separator == NULL || separator == line.begin
+            || separator - line.begin >= OPTION_LENGTH || end - separator > VALUE_LENGTH)
+        {
+            return reportLine(input, "expected an option \"name=value\"");
+        }
+        memcpy(name, line.begin, (size_t) (separator - line.begin));
+        name[separator - line.begin] = '\0';
+        memcpy(value, separator + 1, (size_t) (end - separator - 1));
+        value[end - separator - 1] = '\0';
+        if (strcmp(name, CHECKPOINT_OPTION) == 0)
+        {
+            strcpy(content->checkpoint, value);
+        }
+        else if (strcmp(name, OUT_OF_CORE_OPTION) == 0)
+        {
+            strcpy(content->outOfCore, value);
+        }
+        else if (strcmp(name, PROFILE_OPTION) == 0)
+        {
+            strcpy(content->profile, value);
+        }
+        else if (parseOption(name, value, content->n, content->m, &content->options) == FALSE
+                 && parseOutputOption(name, value, &content->output) == FALSE)
+        {
+            return reportLine(input, "unknown option or invalid value");
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Read a whole input file, in one pass
+ * @param input the file
+ * @param content the content to fill
+ * @return 1 iff the file is valid
+ */
+int getInput(input_file *input, heat_input *content)
+{
+    input_line line;
+    if (!getSize(input, content) || !getSeparator(input) || !getSources(input, content))
+    {
+        return FALSE;
+    }
+    if (!nextContentLine(input, &line))
+    {
+        return reportLine(input, "missing parameter");
+    }
+    if (!parseReal(&line, &content->terminate) || !skipBlanks(&line))
+    {
+        return reportLine(input, "expected a number");
+    }
+    if (!getIntegerLine(input, 0, &content->n_iter)
+        || !getIntegerLine(input, INT_MIN, &content->isCyclic))
+    {
+        return FALSE;
     }
-    for (int i = 0; i < sourcesNumber; i++)
+    return getOptions(input, content);
+}
+
+/**
+ * Set the sources in a zero filled grid
+ * @param grid the grid
+ * @param sourcesNumber number of sources
+ * @param sourcesList sources, all inside the grid
+ */
+void placeSources(heat_grid *grid, size_t sourcesNumber, const source_point *sourcesList)
+{
+    for (size_t j = 0; j < sourcesNumber; j++)
     {
-        int x, y;
-        double value;
-        fscanf(file, "%d, %d, %lf\n", &x, &y, &value);
-        sourcesList[i].x = x;
-        sourcesList[i].y = y;
-        sourcesList[i].value = value;
+        GRID_AT(grid, sourcesList[j].x, sourcesList[j].y) = sourcesList[j].value;
     }
-    return sourcesList;
 }
 
 /**
@@ -85,60 +644,573 @@ source_point *getSourcesList(int sourcesNumber, FILE *file)
  * @param n height of the grid
  * @param m width of the grid
  * @param sourcesNumber number of sources
- * @param sourcesList sources
+ * @param sourcesList sources, all inside the grid
+ * @param options options of the calculations (see allocSolverGrid)
  * @return the grid
  */
-double **getGrid(int n, int m, int sourcesNumber, source_point *sourcesList)
+heat_grid *getGrid(int n, int m, size_t sourcesNumber, source_point *sourcesList,
+                   const calc_options *options)
 {
-    double **grid = (double **) malloc(sizeof(double *) * n);
+    heat_grid *grid = allocSolverGrid((size_t) n, (size_t) m, options);
     if (grid == NULL)
     {
         fprintf(stderr, ERROR_MSG);
         free(sourcesList);
         exit(1);
     }
-    for (int i = 0; i < n; i++)
+    placeSources(grid, sourcesNumber, sourcesList);
+    return grid;
+}
+
+/**
+ * Save a checkpoint of the calculation (a checkpoint_func)
+ * @param arg content of the input
+ * @param grid the latest values of the grid
+ * @param iteration number of iterations done by the calculation
+ * @return 1 iff the snapshot was written
+ */
+int saveInput(void *arg, const heat_grid *grid, unsigned int iteration)
+{
+    const heat_input *content = (const heat_input *) arg;
+    snapshot_params params;
+    memset(&params, 0, sizeof(params));
+    params.terminate = content->terminate;
+    params.n_iter = content->n_iter;
+    params.is_cyclic = content->isCyclic;
+    params.options = content->options;
+    params.output = content->output;
+    params.iteration = iteration;
+    strcpy(params.path, content->checkpoint);
+    return writeSnapshot(content->checkpoint, grid, content->sources, content->sourcesNumber,
+                         &params);
+}
+
+/**
+ * Get the content of a snapshot, to resume its calculation
+ * @param path the snapshot
+ * @param content the content to fill
+ * @return the grid of the snapshot (updated in place)
+ */
+heat_grid *restoreInput(const char *path, heat_input *content)
+{
+    heat_snapshot *snapshot = openSnapshot(path);
+    if (snapshot == NULL)
+    {
+        fprintf(stderr, ERROR_MSG);
+        exit(1);
+    }
+    content->snapshot = snapshot;
+    content->n = (int) snapshot->grid.n;
+    content->m = (int) snapshot->grid.m;
+    content->sources = snapshot->sources;
+    content->sourcesNumber = snapshot->num_sources;
+    content->terminate = snapshot->params.terminate;
+    content->n_iter = snapshot->params.n_iter;
+    content->isCyclic = snapshot->params.is_cyclic;
+    content->options = snapshot->params.options;
+    content->options.start_iteration = snapshot->params.iteration;
+    content->output = snapshot->params.output;
+    strcpy(content->checkpoint, snapshot->params.path);
+    return &snapshot->grid;
+}
+
+/**
+ * Read an input file, and check its options go together
+ * @param path the file
+ * @param content the content to fill (its sources are freed if the file is not valid)
+ * @return 1 iff the file could be read and is valid
+ */
+int readContent(const char *path, heat_input *content)
+{
+    input_file *input = openInput(path);
+    if (input == NULL)
+    {
+        return FALSE;
+    }
+    int valid = getInput(input, content);
+    closeInput(input);
+    // The snapshots hold a grid in memory of one process, and a grid in a file is swept with
+    // heat_eqn
+    const stencil *shape = &content->options.stencil;
+    if (!valid || (content->outOfCore[0] != '\0' && content->checkpoint[0] != '\0')
+        || (content->outOfCore[0] != '\0' && shape->count > 0 && !isHeatStencil(shape))
+        || (content->options.processes > 1 && content->checkpoint[0] != '\0'))
     {
-        grid[i] = (double *) calloc((size_t) m, sizeof(double));
-        if (grid[i] == NULL)
+        free(content->sources);
+        content->sources = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Save the checkpoints of the calculation if the content has a checkpoint file
+ * @param content content of the input
+ */
+void initCheckpoint(heat_input *content)
+{
+    if (content->checkpoint[0] == '\0')
+    {
+        return;
+    }
+    content->options.checkpoint = saveInput;
+    content->options.checkpoint_arg = content;
+    if (content->options.checkpoint_every == 0)
+    {
+        content->options.checkpoint_every = DEFAULT_CHECKPOINT_EVERY;
+    }
+}
+
+/**
+ * Time the run if the content has a profile file
+ * @param content content of the input
+ * @param start the time the input file started to be read
+ */
+void initProfiling(heat_input *content, double start)
+{
+    if (content->profile[0] == '\0')
+    {
+        return;
+    }
+    initProfile(&content->timers);
+    content->options.profile = &content->timers;
+    endPhase(&content->timers, PHASE_PARSE, start);
+}
+
+/**
+ * Write the timers of the run if the content has a profile file
+ * @param content content of the input
+ * @return 1 iff there is no profile file, or the timers were written to it
+ */
+int saveProfile(const heat_input *content)
+{
+    if (content->options.profile == NULL)
+    {
+        return TRUE;
+    }
+    FILE *file = fopen(content->profile, "w");
+    if (file == NULL)
+    {
+        return FALSE;
+    }
+    int written = writeProfile(content->options.profile, file);
+    return fclose(file) == 0 && written;
+}
+
+/**
+ * Read an input file
+ * @param path the file
+ * @param content the content to fill
+ * @return the grid, or NULL for an out of core calculation
+ */
+heat_grid *loadInput(const char *path, heat_input *content)
+{
+    double start = profileClock();
+    if (!readContent(path, content))
+    {
+        fprintf(stderr, ERROR_MSG);
+        exit(1);
+    }
+    initProfiling(content, start);
+    if (content->outOfCore[0] != '\0')
+    {
+        return NULL;
+    }
+    start = startPhase(content->options.profile);
+    heat_grid *grid = getGrid(content->n, content->m, content->sourcesNumber, content->sources,
+                              &content->options);
+    endPhase(content->options.profile, PHASE_SETUP, start);
+    return grid;
+}
+
+/**
+ * Run the calculations on a grid in memory, and write the grids
+ * @param grid the grid
+ * @param content content of the input
+ * @param output the output
+ * @return 1 iff the calculations and the output succeeded
+ */
+int runGrid(heat_grid *grid, heat_input *content, output_stream *output)
+{
+    double diff;
+    unsigned long done = content->options.start_iteration;
+    content->options.drift = &content->drift;
+    heat_profile *profile = content->options.profile;
+    do
+    {
+        double start = startPhase(profile);
+        diff = calculateGrid(heat_eqn, grid, content->sources, content->sourcesNumber,
+                             content->terminate, (unsigned int) content->n_iter,
+                             content->isCyclic, &content->options);
+        start = endPhase(profile, PHASE_SOLVE, start);
+        if (diff >= 0 && content->options.check_precision
+            && content->options.precision != PRECISION_DOUBLE)
         {
-            fprintf(stderr, ERROR_MSG);
-            freeAll(grid, i, sourcesList); // Free grid until i
-            exit(1);
+            fprintf(stderr, DRIFT_FORMAT, content->drift.cells, content->drift.diff,
+                    content->drift.iterations, content->drift.reference_iterations);
+        }
+        // Only the first calculation resumes from the snapshot
+        content->options.start_iteration = 0;
+        int last = diff < content->terminate;
+        // Calculations shorter than the interval are saved between them
+        unsigned long every = content->options.checkpoint_every, previous = done;
+        done += (unsigned long) content->n_iter + 1;
+        int save = content->options.checkpoint != NULL && content->n_iter > 0 && !last
+                   && done / every != previous / every;
+        int failed = diff < 0
+                     || ((last || !content->output.final_only) && !writeGrid(output, diff, grid))
+                     || (save && !saveInput(content, grid, 0));
+        endPhase(profile, PHASE_OUTPUT, start);
+        if (failed)
+        {
+            return FALSE;
         }
+    } while (diff >= content->terminate);
+    return TRUE;
+}
+
+/**
+ * Write a disk grid, a band at a time
+ * @param output the output
+ * @param diff the diff of the last calculation
+ * @param grid the grid
+ * @param rows buffer of a band
+ * @return 1 iff the grid was read and written
+ */
+int writeDiskGrid(output_stream *output, double diff, const disk_grid *grid, heat_grid *rows)
+{
+    int written = beginGrid(output, diff, grid->n, grid->m);
+    for (size_t first = 0; written && first < grid->n; first += rows->n)
+    {
+        heat_grid view = *rows;
+        view.n = first + rows->n < grid->n ? rows->n : grid->n - first;
+        written = readDiskRows(grid, &view, first) && writeRows(output, &view);
     }
-    for (int j = 0; j < sourcesNumber; j++)
+    return written;
+}
+
+/**
+ * Run the calculations on a grid in a file, and write the grids
+ * @param content content of the input
+ * @param output the output
+ * @return 1 iff the calculations and the output succeeded
+ */
+int runDisk(heat_input *content, output_stream *output)
+{
+    size_t band = content->options.band;
+    heat_profile *profile = content->options.profile;
+    double start = startPhase(profile);
+    disk_grid *grid = createDiskGrid(content->outOfCore, (size_t) content->n,
+                                     (size_t) content->m);
+    heat_grid *rows = grid != NULL ? allocGrid(band, grid->m) : NULL;
+    int done = rows != NULL
+               && placeDiskSources(grid, content->sources, content->sourcesNumber, band);
+    start = endPhase(profile, PHASE_SETUP, start);
+    double diff;
+    do
+    {
+        diff = done ? calculateDisk(heat_eqn, grid, content->sources, content->sourcesNumber,
+                                    content->terminate, (unsigned int) content->n_iter,
+                                    content->isCyclic, &content->options) : -1;
+        start = endPhase(profile, PHASE_SOLVE, start);
+        int last = diff < content->terminate;
+        done = diff >= 0 && ((!last && content->output.final_only)
+                             || writeDiskGrid(output, diff, grid, rows));
+        start = endPhase(profile, PHASE_OUTPUT, start);
+    } while (done && diff >= content->terminate);
+    freeGrid(rows);
+    closeDiskGrid(grid);
+    return done;
+}
+
+/**
+ * Copy a string
+ * @param text the string
+ * @param length its length
+ * @return the copy, or NULL if it could not be allocated
+ */
+char *copyString(const char *text, size_t length)
+{
+    char *copy = (char *) malloc(length + 1);
+    if (copy != NULL)
     {
-        if (sourcesList[j].x >= n || sourcesList[j].y >= m)
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+/**
+ * Add an input file to a batch
+ * @param batch the batch
+ * @param capacity number of inputs the batch has room for, updated
+ * @param path the file
+ * @param length length of the path
+ * @return 1 iff it could be added
+ */
+int addJob(heat_batch *batch, size_t *capacity, const char *path, size_t length)
+{
+    if (batch->count == *capacity)
+    {
+        size_t bigger = *capacity > 0 ? 2 * *capacity : SOURCES_CAPACITY;
+        char **inputs = (char **) realloc(batch->inputs, sizeof(char *) * bigger);
+        if (inputs == NULL)
         {
-            fprintf(stderr, ERROR_MSG);
-            freeAll(grid, n, sourcesList);
-            exit(1);
+            return FALSE;
         }
-        grid[sourcesList[j].x][sourcesList[j].y] = sourcesList[j].value;
+        batch->inputs = inputs;
+        *capacity = bigger;
     }
-    return grid;
+    batch->inputs[batch->count] = copyString(path, length);
+    return batch->inputs[batch->count++] != NULL;
 }
 
 /**
- * printing the given grid
- * @param grid grid
- * @param n height
- * @param m width
+ * Compare the paths of two inputs of a batch
+ * @param a first path
+ * @param b second path
+ * @return the order of the paths
  */
-void printGrid(double **grid, int n, int m)
+int comparePaths(const void *a, const void *b)
 {
-    for (int i = 0; i < n; i++)
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+/**
+ * Get the inputs of a batch from a directory: its regular files (but the hidden ones), by name
+ * @param batch the batch
+ * @param path the directory
+ * @return 1 iff the directory could be read
+ */
+int listDirectory(heat_batch *batch, const char *path)
+{
+    DIR *directory = opendir(path);
+    if (directory == NULL)
+    {
+        return FALSE;
+    }
+    size_t capacity = 0;
+    int listed = TRUE;
+    struct dirent *entry;
+    while (listed && (entry = readdir(directory)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        size_t length = strlen(path) + 1 + strlen(entry->d_name);
+        char *file = (char *) malloc(length + 1);
+        struct stat status;
+        listed = file != NULL;
+        if (listed)
+        {
+            sprintf(file, "%s/%s", path, entry->d_name);
+        }
+        if (listed && stat(file, &status) == 0 && S_ISREG(status.st_mode))
+        {
+            listed = addJob(batch, &capacity, file, length);
+        }
+        free(file);
+    }
+    closedir(directory);
+    if (listed && batch->count > 1)
+    {
+        qsort(batch->inputs, batch->count, sizeof(char *), comparePaths);
+    }
+    return listed;
+}
+
+/**
+ * Get the inputs of a batch from a manifest: a path per line (blank lines are skipped)
+ * @param batch the batch
+ * @param path the manifest
+ * @return 1 iff the manifest could be read
+ */
+int listManifest(heat_batch *batch, const char *path)
+{
+    input_file *input = openInput(path);
+    if (input == NULL)
+    {
+        return FALSE;
+    }
+    size_t capacity = 0;
+    int listed = TRUE;
+    input_line line;
+    while (listed && nextContentLine(input, &line))
+    {
+        const char *end = line.end;
+        while (end[-1] == ' ' || end[-1] == '\t')
+        {
+            end--;
+        }
+        listed = addJob(batch, &capacity, line.begin, (size_t) (end - line.begin));
+    }
+    closeInput(input);
+    return listed;
+}
+
+/**
+ * Get the output file of an input of a batch: its name with OUTPUT_SUFFIX, in the output
+ * directory
+ * @param batch the batch
+ * @param job the input
+ * @return the path, or NULL if it could not be allocated
+ */
+char *getOutputPath(const heat_batch *batch, size_t job)
+{
+    const char *name = strrchr(batch->inputs[job], '/');
+    name = name != NULL ? name + 1 : batch->inputs[job];
+    char *path = (char *) malloc(strlen(batch->outputDir) + 1 + strlen(name)
+                                 + sizeof(OUTPUT_SUFFIX));
+    if (path != NULL)
+    {
+        sprintf(path, "%s/%s%s", batch->outputDir, name, OUTPUT_SUFFIX);
+    }
+    return path;
+}
+
+/**
+ * Run a job of a batch: solve an input file and write its grids to its output file
+ * @param batch the batch
+ * @param worker the worker running the job
+ * @param job the input
+ * @return 1 iff the input was valid, and the calculations and the output succeeded
+ */
+int runJob(const heat_batch *batch, batch_worker *worker, size_t job)
+{
+    heat_input content;
+    memset(&content, 0, sizeof(content));
+    double start = profileClock();
+    if (!readContent(batch->inputs[job], &content))
+    {
+        return FALSE;
+    }
+    initProfiling(&content, start);
+    initCheckpoint(&content);
+    char *path = getOutputPath(batch, job);
+    FILE *file = path != NULL ? fopen(path, "w") : NULL;
+    free(path);
+    if (file == NULL)
+    {
+        free(content.sources);
+        return FALSE;
+    }
+    redirectOutput(worker->output, file, content.output.format);
+    int solved;
+    if (content.outOfCore[0] != '\0')
     {
-        for (int j = 0; j < m; j++)
+        solved = runDisk(&content, worker->output);
+    }
+    else
+    {
+        start = startPhase(content.options.profile);
+        heat_grid *grid = takeGrid(&worker->grids, (size_t) content.n, (size_t) content.m);
+        solved = grid != NULL;
+        if (solved)
         {
-            printf("%.4f,", grid[i][j]);
+            placeSources(grid, content.sourcesNumber, content.sources);
+            endPhase(content.options.profile, PHASE_SETUP, start);
+            solved = runGrid(grid, &content, worker->output);
+        }
+        returnGrid(&worker->grids, grid);
+    }
+    start = startPhase(content.options.profile);
+    int written = redirectOutput(worker->output, NULL, content.output.format) && solved;
+    written = fclose(file) == 0 && written;
+    endPhase(content.options.profile, PHASE_OUTPUT, start);
+    free(content.sources);
+    return saveProfile(&content) && written;
+}
 
+/**
+ * The part of a worker in a batch: take the next job until there is none left
+ * @param arg the batch
+ * @param thread the worker
+ */
+void batchTask(void *arg, unsigned int thread)
+{
+    heat_batch *batch = (heat_batch *) arg;
+    batch_worker *worker = &batch->workers[thread];
+    for (unsigned long job = poolNext(batch->pool); job < batch->count;
+         job = poolNext(batch->pool))
+    {
+        if (!runJob(batch, worker, (size_t) job))
+        {
+            fprintf(stderr, JOB_ERROR_FORMAT, batch->inputs[job]);
+            worker->failed++;
         }
-        printf("\n");
     }
 }
 
+/**
+ * Free the inputs and the workers of a batch
+ * @param batch the batch
+ * @param workers number of workers
+ */
+void freeBatch(heat_batch *batch, unsigned int workers)
+{
+    for (size_t job = 0; job < batch->count; job++)
+    {
+        free(batch->inputs[job]);
+    }
+    free(batch->inputs);
+    for (unsigned int t = 0; batch->workers != NULL && t < workers; t++)
+    {
+        clearGridPool(&batch->workers[t].grids);
+        closeOutput(batch->workers[t].output);
+    }
+    free(batch->workers);
+    freePool(batch->pool);
+}
+
+/**
+ * Solve many input files in one process, on a pool of workers which keep their buffers
+ * @param list a manifest, or a directory of input files
+ * @param outputDir the directory of the outputs
+ * @param workers number of workers, 0 for one per processor (at most one per job)
+ * @return 1 iff every job succeeded
+ */
+int runBatch(const char *list, const char *outputDir, long workers)
+{
+    heat_batch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.outputDir = outputDir;
+    struct stat status;
+    int listed = stat(list, &status) == 0
+                 && (S_ISDIR(status.st_mode) ? listDirectory(&batch, list)
+                                             : listManifest(&batch, list));
+    if (workers == 0)
+    {
+        workers = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (workers < 1 || (size_t) workers > batch.count)
+    {
+        workers = workers > 1 && batch.count > 0 ? (long) batch.count : 1;
+    }
+    batch.workers = (batch_worker *) calloc((size_t) workers, sizeof(batch_worker));
+    int ready = listed && batch.workers != NULL;
+    for (long t = 0; ready && t < workers; t++)
+    {
+        batch.workers[t].output = openOutput(NULL, OUTPUT_TEXT);
+        ready = batch.workers[t].output != NULL;
+    }
+    batch.pool = ready ? createPool((unsigned int) workers) : NULL;
+    if (batch.pool == NULL)
+    {
+        fprintf(stderr, ERROR_MSG);
+        freeBatch(&batch, (unsigned int) workers);
+        exit(1);
+    }
+    runPool(batch.pool, batchTask, &batch);
+    unsigned long failed = 0;
+    for (long t = 0; t < workers; t++)
+    {
+        failed += batch.workers[t].failed;
+    }
+    freeBatch(&batch, (unsigned int) workers);
+    return failed == 0;
+}
+
 /**
  * main function
  * @param argc number of args
@@ -147,39 +1219,45 @@ void printGrid(double **grid, int n, int m)
  */
 int main(int argc, char *argv[])
 {
-    if (argc != 2)
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], BATCH_FLAG) == 0)
+    {
+        char *end = NULL;
+        long workers = argc == 5 ? strtol(argv[4], &end, 10) : 0;
+        if (argc == 5 && (*end != '\0' || workers < 1))
+        {
+            fprintf(stderr, CORRECT_USAGE);
+            exit(1);
+        }
+        return runBatch(argv[2], argv[3], workers) ? 0 : 1;
+    }
+    int restart = argc == 3 && strcmp(argv[1], RESTART_FLAG) == 0;
+    if (argc != 2 && !restart)
     {
         fprintf(stderr, CORRECT_USAGE);
         exit(1);
     }
-    FILE *file = fopen(argv[1], "r");
-    if (file == NULL)
+    heat_input content;
+    memset(&content, 0, sizeof(content));
+    heat_grid *grid = restart ? restoreInput(argv[2], &content) : loadInput(argv[1], &content);
+    initCheckpoint(&content);
+    output_stream *output = openOutput(stdout, content.output.format);
+    if (output == NULL)
     {
         fprintf(stderr, ERROR_MSG);
+        freeAll(grid, &content);
         exit(1);
     }
-    int sourcesNumber = getLinesNumber(file) - NON_SOURCES_LINES;
-    int m = 0, n = 0;
-    fscanf(file, "%d, %d\n", &n, &m);
-    fscanf(file, SEPARATOR);
-    source_point *sourcesList = getSourcesList(sourcesNumber, file);
-    fscanf(file, SEPARATOR);
-    int n_iter, isCyclic;
-    double terminate;
-    fscanf(file, "%lf\n", &terminate);
-    fscanf(file, "%d\n", &n_iter);
-    fscanf(file, "%d\n", &isCyclic);
-    fclose(file);
-    double **grid = getGrid(n, m, sourcesNumber, sourcesList);
-    double diff;
-    do
+    int solved = grid != NULL ? runGrid(grid, &content, output) : runDisk(&content, output);
+    double start = startPhase(content.options.profile);
+    int written = closeOutput(output) && solved;
+    endPhase(content.options.profile, PHASE_OUTPUT, start);
+    written = saveProfile(&content) && written;
+    freeAll(grid, &content);
+    if (!written)
     {
-        diff = calculate(heat_eqn, grid, (size_t) n, (size_t) m, sourcesList,
-                         (size_t) sourcesNumber, terminate, (unsigned int) n_iter, isCyclic);
-        printf("%lf\n", diff);
-        printGrid(grid, n, m);
-    } while (diff >= terminate);
-    freeAll(grid, n, sourcesList);
+        fprintf(stderr, ERROR_MSG);
+        exit(1);
+    }
     return 0;
 }
 
@@ -0,0 +1,494 @@
+/**
+ * @file simd.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Vectorised heat_eqn sweeps, with the instruction set chosen at run time.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <math.h>
+#include <string.h>
+#include "simd.h"
+#include "heat_eqn.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#endif
+// -------------------------- const definitions -------------------------
+#define QUARTER 0.25
+#define SSE_FLOATS 4
+#define AVX_FLOATS 8
+// ------------------------------ macros -----------------------------
+/**
+ * New values of the 4 inner float cells of a row from column j, with SSE2
+ */
+#define HEAT_CELLS_SSE(up, row, down, j) \
+    _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps((row) + (j) + 1), _mm_loadu_ps((row) + (j) - 1)), \
+                          _mm_add_ps(_mm_loadu_ps((up) + (j)), _mm_loadu_ps((down) + (j)))), \
+               _mm_set1_ps((float) QUARTER))
+
+/**
+ * New values of the 8 inner float cells of a row from column j, with AVX2
+ */
+#define HEAT_CELLS_AVX(up, row, down, j) \
+    _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps((row) + (j) + 1), \
+                                              _mm256_loadu_ps((row) + (j) - 1)), \
+                                _mm256_add_ps(_mm256_loadu_ps((up) + (j)), \
+                                              _mm256_loadu_ps((down) + (j)))), \
+                  _mm256_set1_ps((float) QUARTER))
+// ------------------------------ functions -----------------------------
+
+/**
+ * Scalar sweep
+ * @param out row to write
+ * @param up row above
+ * @param row row of the cells
+ * @param down row below
+ * @param from first column
+ * @param to end column
+ * @param change the sum of the changes so far
+ * @return the sum including the changes of the updated cells
+ */
+double heatInteriorScalar(double *out, const double *up, const double *row, const double *down,
+                          size_t from, size_t to, double change)
+{
+    for (size_t j = from; j < to; j++)
+    {
+        double value = HEAT_EQN(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+        change += value - row[j];
+        out[j] = value;
+    }
+    return change;
+}
+
+/**
+ * Scalar sweep of floats
+ * @param out row to write
+ * @param up row above
+ * @param row row of the cells
+ * @param down row below
+ * @param from first column
+ * @param to end column
+ * @param mode how the changes are added up
+ * @param carry the carry of SUM_KAHAN, updated
+ * @param change the sum of the changes so far
+ * @return the sum including the changes of the updated cells
+ */
+double heatInteriorFloatScalar(float *out, const float *up, const float *row,
+                               const float *down, size_t from, size_t to, sum_mode mode,
+                               double *carry, double change)
+{
+    if (mode == SUM_FLOAT)
+    {
+        float sum = (float) change;
+        for (size_t j = from; j < to; j++)
+        {
+            float value = HEAT_EQN(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+            sum += value - row[j];
+            out[j] = value;
+        }
+        return sum;
+    }
+    if (mode == SUM_KAHAN)
+    {
+        float sum = (float) change, compensation = (float) *carry;
+        for (size_t j = from; j < to; j++)
+        {
+            float value = HEAT_EQN(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+            KAHAN_ADD(sum, compensation, value - row[j]);
+            out[j] = value;
+        }
+        *carry = compensation;
+        return sum;
+    }
+    for (size_t j = from; j < to; j++)
+    {
+        float value = HEAT_EQN(row[j], row[j + 1], up[j], row[j - 1], down[j]);
+        change += (double) value - row[j];
+        out[j] = value;
+    }
+    return change;
+}
+
+/**
+ * Add the lanes of a vector of float sums to a sum
+ * @param sums the lanes
+ * @param carries the carries of the lanes (SUM_KAHAN only)
+ * @param lanes number of lanes
+ * @param mode SUM_FLOAT or SUM_KAHAN
+ * @param carry the carry of SUM_KAHAN, updated
+ * @param change the sum
+ * @return the sum including the lanes
+ */
+double addFloatLanes(const float *sums, const float *carries, size_t lanes, sum_mode mode,
+                     double *carry, double change)
+{
+    float sum = (float) change, compensation = (float) *carry;
+    for (size_t k = 0; k < lanes; k++)
+    {
+        if (mode == SUM_KAHAN)
+        {
+            KAHAN_ADD(sum, compensation, sums[k]);
+            KAHAN_ADD(sum, compensation, -carries[k]);
+        }
+        else
+        {
+            sum += sums[k];
+        }
+    }
+    *carry = compensation;
+    return sum;
+}
+
+#ifdef SIMD_X86
+/**
+ * SSE2 sweep, 2 cells at a time ((right + left) + (top + bottom)) * 0.25 like HEAT_EQN
+ * (the division by 4 is exact as a multiplication)
+ * @param out row to write
+ * @param up row above
+ * @param row row of the cells
+ * @param down row below
+ * @param from first column
+ * @param to end column
+ * @param change the sum of the changes so far
+ * @return the sum including the changes of the updated cells
+ */
+__attribute__((target("sse2")))
+double heatInteriorSse2(double *out, const double *up, const double *row, const double *down,
+                        size_t from, size_t to, double change)
+{
+    const __m128d quarter = _mm_set1_pd(QUARTER);
+    __m128d total = _mm_setzero_pd();
+    size_t j = from;
+    for (; j + 2 <= to; j += 2)
+    {
+        __m128d horizontal = _mm_add_pd(_mm_loadu_pd(row + j + 1), _mm_loadu_pd(row + j - 1));
+        __m128d vertical = _mm_add_pd(_mm_loadu_pd(up + j), _mm_loadu_pd(down + j));
+        __m128d cells = _mm_mul_pd(_mm_add_pd(horizontal, vertical), quarter);
+        _mm_storeu_pd(out + j, cells);
+        total = _mm_add_pd(total, _mm_sub_pd(cells, _mm_loadu_pd(row + j)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, total);
+    return heatInteriorScalar(out, up, row, down, j, to, change + (lanes[0] + lanes[1]));
+}
+
+/**
+ * AVX2 sweep, 4 cells at a time
+ * @param out row to write
+ * @param up row above
+ * @param row row of the cells
+ * @param down row below
+ * @param from first column
+ * @param to end column
+ * @param change the sum of the changes so far
+ * @return the sum including the changes of the updated cells
+ */
+__attribute__((target("avx2")))
+double heatInteriorAvx2(double *out, const double *up, const double *row, const double *down,
+                        size_t from, size_t to, double change)
+{
+    const __m256d quarter = _mm256_set1_pd(QUARTER);
+    __m256d total = _mm256_setzero_pd();
+    size_t j = from;
+    for (; j + 4 <= to; j += 4)
+    {
+        __m256d horizontal = _mm256_add_pd(_mm256_loadu_pd(row + j + 1),
+                                           _mm256_loadu_pd(row + j - 1));
+        __m256d vertical = _mm256_add_pd(_mm256_loadu_pd(up + j), _mm256_loadu_pd(down + j));
+        __m256d cells = _mm256_mul_pd(_mm256_add_pd(horizontal, vertical), quarter);
+        _mm256_storeu_pd(out + j, cells);
+        total = _mm256_add_pd(total, _mm256_sub_pd(cells, _mm256_loadu_pd(row + j)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, total);
+    return heatInteriorScalar(out, up, row, down, j, to,
+                              change + ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])));
+}
+
+/**
+ * SSE2 sweep of floats, 4 cells at a time
+ * @param out row to write
+ * @param up row above
+ * @param row row of the cells
+ * @param down row below
+ * @param from first column
+ * @param to end column
+ * @param mode how the changes are added up
+ * @param carry the carry of SUM_KAHAN, updated
+ * @param change the sum of the changes so far
+ * @return the sum including the changes of the updated cells
+ */
+__attribute__((target("sse2")))
+double heatInteriorFloatSse2(float *out, const float *up, const float *row, const float *down,
+                             size_t from, size_t to, sum_mode mode, double *carry,
+                             double change)
+{
+    size_t j = from;
+    if (mode == SUM_DOUBLE)
+    {
+        // The changes are exact in double: both halves of the cells are widened first
+        __m128d low = _mm_setzero_pd(), high = _mm_setzero_pd();
+        for (; j + SSE_FLOATS <= to; j += SSE_FLOATS)
+        {
+            __m128 cells = HEAT_CELLS_SSE(up, row, down, j);
+            __m128 old = _mm_loadu_ps(row + j);
+            _mm_storeu_ps(out + j, cells);
+            low = _mm_add_pd(low, _mm_sub_pd(_mm_cvtps_pd(cells), _mm_cvtps_pd(old)));
+            high = _mm_add_pd(high, _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(cells, cells)),
+                                               _mm_cvtps_pd(_mm_movehl_ps(old, old))));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+        change += lanes[0] + lanes[1];
+    }
+    else
+    {
+        __m128 total = _mm_setzero_ps(), compensation = _mm_setzero_ps();
+        for (; j + SSE_FLOATS <= to; j += SSE_FLOATS)
+        {
+            __m128 cells = HEAT_CELLS_SSE(up, row, down, j);
+            __m128 delta = _mm_sub_ps(cells, _mm_loadu_ps(row + j));
+            _mm_storeu_ps(out + j, cells);
+            if (mode == SUM_KAHAN)
+            {
+                __m128 adjusted = _mm_sub_ps(delta, compensation);
+                __m128 sum = _mm_add_ps(total, adjusted);
+                compensation = _mm_sub_ps(_mm_sub_ps(sum, total), adjusted);
+                total = sum;
+            }
+            else
+            {
+                total = _mm_add_ps(total, delta);
+            }
+        }
+        float sums[SSE_FLOATS], carries[SSE_FLOATS];
+        _mm_storeu_ps(sums, total);
+        _mm_storeu_ps(carries, compensation);
+        change = addFloatLanes(sums, carries, SSE_FLOATS, mode, carry, change);
+    }
+    return heatInteriorFloatScalar(out, up, row, down, j, to, mode, carry, change);
+}
+
+/**
+ * AVX2 sweep of floats, 8 cells at a time
+ * @param out row to write
+ * @param up row above
+ * @param row row of the cells
+ * @param down row below
+ * @param from first column
+ * @param to end column
+ * @param mode how the changes are added up
+ * @param carry the carry of SUM_KAHAN, updated
+ * @param change the sum of the changes so far
+ * @return the sum including the changes of the updated cells
+ */
+__attribute__((target("avx2")))
+double heatInteriorFloatAvx2(float *out, const float *up, const float *row, const float *down,
+                             size_t from, size_t to, sum_mode mode, double *carry,
+                             double change)
+{
+    size_t j = from;
+    if (mode == SUM_DOUBLE)
+    {
+        // The changes are exact in double: both halves of the cells are widened first
+        __m256d low = _mm256_setzero_pd(), high = _mm256_setzero_pd();
+        for (; j + AVX_FLOATS <= to; j += AVX_FLOATS)
+        {
+            __m256 cells = HEAT_CELLS_AVX(up, row, down, j);
+            __m256 old = _mm256_loadu_ps(row + j);
+            _mm256_storeu_ps(out + j, cells);
+            low = _mm256_add_pd(low, _mm256_sub_pd(
+                    _mm256_cvtps_pd(_mm256_castps256_ps128(cells)),
+                    _mm256_cvtps_pd(_mm256_castps256_ps128(old))));
+            high = _mm256_add_pd(high, _mm256_sub_pd(
+                    _mm256_cvtps_pd(_mm256_extractf128_ps(cells, 1)),
+                    _mm256_cvtps_pd(_mm256_extractf128_ps(old, 1))));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(low, high));
+        change += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+    else
+    {
+        __m256 total = _mm256_setzero_ps(), compensation = _mm256_setzero_ps();
+        for (; j + AVX_FLOATS <= to; j += AVX_FLOATS)
+        {
+            __m256 cells = HEAT_CELLS_AVX(up, row, down, j);
+            __m256 delta = _mm256_sub_ps(cells, _mm256_loadu_ps(row + j));
+            _mm256_storeu_ps(out + j, cells);
+            if (mode == SUM_KAHAN)
+            {
+                __m256 adjusted = _mm256_sub_ps(delta, compensation);
+                __m256 sum = _mm256_add_ps(total, adjusted);
+                compensation = _mm256_sub_ps(_mm256_sub_ps(sum, total), adjusted);
+                total = sum;
+            }
+            else
+            {
+                total = _mm256_add_ps(total, delta);
+            }
+        }
+        float sums[AVX_FLOATS], carries[AVX_FLOATS];
+        _mm256_storeu_ps(sums, total);
+        _mm256_storeu_ps(carries, compensation);
+        change = addFloatLanes(sums, carries, AVX_FLOATS, mode, carry, change);
+    }
+    return heatInteriorFloatScalar(out, up, row, down, j, to, mode, carry, change);
+}
+
+/**
+ * AVX-512 sweep, 8 cells at a time
+ * @param out row to write
+ * @param up row above
+ * @param row row of the cells
+ * @param down row below
+ * @param from first column
+ * @param to end column
+ * @param change the sum of the changes so far
+ * @return the sum including the changes of the updated cells
+ */
+__attribute__((target("avx512f")))
+double heatInteriorAvx512(double *out, const double *up, const double *row, const double *down,
+                          size_t from, size_t to, double change)
+{
+    const __m512d quarter = _mm512_set1_pd(QUARTER);
+    __m512d total = _mm512_setzero_pd();
+    size_t j = from;
+    for (; j + 8 <= to; j += 8)
+    {
+        __m512d horizontal = _mm512_add_pd(_mm512_loadu_pd(row + j + 1),
+                                           _mm512_loadu_pd(row + j - 1));
+        __m512d vertical = _mm512_add_pd(_mm512_loadu_pd(up + j), _mm512_loadu_pd(down + j));
+        __m512d cells = _mm512_mul_pd(_mm512_add_pd(horizontal, vertical), quarter);
+        _mm512_storeu_pd(out + j, cells);
+        total = _mm512_add_pd(total, _mm512_sub_pd(cells, _mm512_loadu_pd(row + j)));
+    }
+    return heatInteriorScalar(out, up, row, down, j, to, change + _mm512_reduce_add_pd(total));
+}
+#endif
+
+/**
+ * Get the best instruction set of this CPU
+ * @return the instruction set (never SIMD_AUTO)
+ */
+simd_level detectSimd(void)
+{
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SIMD_SSE2;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+/**
+ * Get the sweep of an instruction set (or of the best one below it that the CPU has)
+ * @param level the instruction set
+ * @return the sweep
+ */
+heat_interior_func getHeatInterior(simd_level level)
+{
+    simd_level best = detectSimd();
+    if (level == SIMD_AUTO || level > best)
+    {
+        level = best;
+    }
+    switch (level)
+    {
+#ifdef SIMD_X86
+        case SIMD_AVX512:
+            return heatInteriorAvx512;
+        case SIMD_AVX2:
+            return heatInteriorAvx2;
+        case SIMD_SSE2:
+            return heatInteriorSse2;
+#endif
+        default:
+            return heatInteriorScalar;
+    }
+}
+
+/**
+ * Get the float sweep of an instruction set (or of the best one below it that the CPU has)
+ * @param level the instruction set
+ * @return the sweep
+ */
+heat_interior32_func getHeatInterior32(simd_level level)
+{
+    simd_level best = detectSimd();
+    if (level == SIMD_AUTO || level > best)
+    {
+        level = best;
+    }
+    switch (level)
+    {
+#ifdef SIMD_X86
+        case SIMD_AVX512:
+        case SIMD_AVX2:
+            return heatInteriorFloatAvx2;
+        case SIMD_SSE2:
+            return heatInteriorFloatSse2;
+#endif
+        default:
+            return heatInteriorFloatScalar;
+    }
+}
+
+/**
+ * Get the relative difference of two values
+ * @param value the value
+ * @param expected the expected value
+ * @return the relative difference
+ */
+double relativeDifference(double value, double expected)
+{
+    return fabs(value - expected) / (fabs(expected) > 1 ? fabs(expected) : 1);
+}
+
+/**
+ * Compare the sweep of an instruction set with the scalar one, on every inner row of a grid
+ * @param level the instruction set
+ * @param grid the grid (not changed)
+ * @return the maximal relative difference of the cells and of the sums of
+ * their changes, or -1 if the
+ * working memory could not be allocated
+ */
+double compareSimd(simd_level level, const heat_grid *grid)
+{
+    heat_interior_func vector = getHeatInterior(level);
+    double *rows = (double *) malloc(sizeof(double) * 2 * (grid->m > 0 ? grid->m : 1));
+    if (rows == NULL)
+    {
+        return -1;
+    }
+    double *expected = rows, *actual = rows + grid->m;
+    double worst = 0;
+    for (size_t i = 1; i + 1 < grid->n && grid->m > 2; i++)
+    {
+        const double *row = GRID_ROW(grid, i);
+        const double *up = row - grid->stride, *down = row + grid->stride;
+        double expectedChange = heatInteriorScalar(expected, up, row, down, 1, grid->m - 1, 0);
+        double actualChange = vector(actual, up, row, down, 1, grid->m - 1, 0);
+        double difference = relativeDifference(actualChange, expectedChange);
+        worst = difference > worst ? difference : worst;
+        for (size_t j = 1; j + 1 < grid->m; j++)
+        {
+            difference = relativeDifference(actual[j], expected[j]);
+            worst = difference > worst ? difference : worst;
+        }
+    }
+    free(rows);
+    return worst;
+}
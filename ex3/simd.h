@@ -0,0 +1,112 @@
+/**
+ * @file simd.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Vectorised heat_eqn sweeps
+ * @section DESCRIPTION
+ * The inner cells of a Jacobi sweep of heat_eqn are independent, so they are updated with
+ * SSE2, AVX2 or AVX-512 when the CPU has it (checked at run time), or with a scalar loop.
+ * Every cell gets exactly the scalar value, only the order in which the sum of
+ * their changes is added differs.
+ * The sweeps of float grids update twice as many cells per instruction, and add the changes
+ * up as chosen by a sum_mode.
+ */
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stdlib.h>
+#include "grid.h"
+
+// -------------------------- const definitions -------------------------
+/**
+ * Maximal relative difference allowed between the vector and the scalar sweeps.
+ */
+#define SIMD_TOLERANCE 1e-9
+
+/**
+ * Instruction sets of the vector sweep. SIMD_AUTO is the best one the CPU has.
+ */
+typedef enum
+{
+	SIMD_AUTO,
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_AVX512
+} simd_level;
+
+/**
+ * How the changes of float cells are added up. SUM_DOUBLE adds them in double, SUM_FLOAT in
+ * float, and SUM_KAHAN in float with Kahan compensated summation: the sum is then
+ * sum - carry, where carry is the rounding error not yet taken back (see addKahan).
+ */
+typedef enum
+{
+	SUM_DOUBLE,
+	SUM_FLOAT,
+	SUM_KAHAN
+} sum_mode;
+
+/**
+ * Update the inner cells [from, to) of a row with heat_eqn, and add their changes
+ * (new - old value) to change.
+ * out is the row to write, up, row and down are the rows to read (out is not one of them).
+ */
+typedef double (*heat_interior_func)(double *out, const double *up, const double *row,
+                                     const double *down, size_t from, size_t to, double change);
+
+/**
+ * Update the inner cells [from, to) of a row of floats with heat_eqn, and add their changes
+ * to change with the given mode (carry is the carry of SUM_KAHAN, updated).
+ * out is the row to write, up, row and down are the rows to read (out is not one of them).
+ */
+typedef double (*heat_interior32_func)(float *out, const float *up, const float *row,
+                                       const float *down, size_t from, size_t to, sum_mode mode,
+                                       double *carry, double change);
+
+// ------------------------------ macros -----------------------------
+/**
+ * Add a float change to a compensated sum (Kahan summation), as a statement so the sweeps can
+ * inline it. sum and carry are float variables.
+ */
+#define KAHAN_ADD(sum, carry, delta) \
+	do \
+	{ \
+		float kahanAdjusted = (float) (delta) - (carry); \
+		float kahanTotal = (sum) + kahanAdjusted; \
+		(carry) = (kahanTotal - (sum)) - kahanAdjusted; \
+		(sum) = kahanTotal; \
+	} while (0)
+
+// ------------------------------ functions -----------------------------
+/**
+ * Get the best instruction set of this CPU
+ * @return the instruction set (never SIMD_AUTO)
+ */
+simd_level detectSimd(void);
+
+/**
+ * Get the sweep of an instruction set (or of the best one below it that the CPU has)
+ * @param level the instruction set
+ * @return the sweep
+ */
+heat_interior_func getHeatInterior(simd_level level);
+
+/**
+ * Get the float sweep of an instruction set (or of the best one below it that the CPU has).
+ * AVX-512 uses the AVX2 sweep.
+ * @param level the instruction set
+ * @return the sweep
+ */
+heat_interior32_func getHeatInterior32(simd_level level);
+
+/**
+ * Compare the sweep of an instruction set with the scalar one, on every inner row of a grid
+ * @param level the instruction set
+ * @param grid the grid (not changed)
+ * @return the maximal relative difference of the cells and of the sums of their
+ * changes, or -1 if the working memory could not be allocated
+ */
+double compareSimd(simd_level level, const heat_grid *grid);
+
+#endif
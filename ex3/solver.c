@@ -0,0 +1,226 @@
+/**
+ * @file solver.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Solvers: a grid and a session of the calculator, checked arguments and status codes.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <stdlib.h>
+#include "solver.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+// ------------------------------ structs -----------------------------
+
+/**
+ * A solver: its grid, the session of the grid, and the iterations run by the session before
+ * the solver got it.
+ */
+struct heat_solver
+{
+    heat_grid *grid;
+    calc_session *session;
+    unsigned long start;
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Create a solver of a n x m grid of zeros, without sources
+ * @param solver set to the solver, NULL on error
+ * @param function function to apply
+ * @param n height of the grid (at least 1)
+ * @param m width of the grid (at least 1)
+ * @param max_sources number of sources the solver has room for
+ * @param is_cyclic tell how to deal with borders
+ * @param options the options (NULL for the defaults), see openSession
+ * @return the status
+ */
+solver_status createSolver(heat_solver **solver, diff_func function, size_t n, size_t m,
+                           size_t max_sources, int is_cyclic, const calc_options *options)
+{
+    *solver = NULL;
+    calc_options defaults;
+    if (options == NULL)
+    {
+        initOptions(&defaults);
+        options = &defaults;
+    }
+    if (function == NULL || n == 0 || m == 0)
+    {
+        return SOLVER_INVALID;
+    }
+    if (options->scheme == SCHEME_MULTIGRID || options->processes > 1 || options->tile > 1)
+    {
+        return SOLVER_UNSUPPORTED;
+    }
+    heat_solver *created = (heat_solver *) malloc(sizeof(heat_solver));
+    if (created == NULL)
+    {
+        return SOLVER_NO_MEMORY;
+    }
+    created->grid = allocSolverGrid(n, m, options);
+    if (created->grid == NULL)
+    {
+        free(created);
+        return SOLVER_NO_MEMORY;
+    }
+    created->session = openSession(function, created->grid, max_sources, is_cyclic, options);
+    if (created->session == NULL)
+    {
+        freeGrid(created->grid);
+        free(created);
+        return SOLVER_SETUP_FAILED;
+    }
+    created->start = sessionIterations(created->session);
+    *solver = created;
+    return SOLVER_OK;
+}
+
+/**
+ * Free a solver and its grid
+ * @param solver the solver (may be NULL)
+ */
+void freeSolver(heat_solver *solver)
+{
+    if (solver == NULL)
+    {
+        return;
+    }
+    closeSession(solver->session);
+    freeGrid(solver->grid);
+    free(solver);
+}
+
+/**
+ * Get the grid of a solver, to read or write it between runs
+ * @param solver the solver
+ * @return the grid
+ */
+heat_grid *solverGrid(heat_solver *solver)
+{
+    return solver->grid;
+}
+
+/**
+ * Replace the sources of a solver, and write their values to their cells
+ * @param solver the solver
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @return the status (the sources are unchanged on error)
+ */
+solver_status setSolverSources(heat_solver *solver, const source_point *sources,
+                               size_t num_sources)
+{
+    heat_grid *grid = solver->grid;
+    for (size_t k = 0; k < num_sources; k++)
+    {
+        if (sources[k].x < 0 || sources[k].y < 0 || (size_t) sources[k].x >= grid->n
+            || (size_t) sources[k].y >= grid->m)
+        {
+            return SOLVER_INVALID;
+        }
+    }
+    if (!setSessionSources(solver->session, sources, num_sources))
+    {
+        return SOLVER_TOO_MANY_SOURCES;
+    }
+    for (size_t k = 0; k < num_sources; k++)
+    {
+        GRID_AT(grid, sources[k].x, sources[k].y) = sources[k].value;
+    }
+    return SOLVER_OK;
+}
+
+/**
+ * Run a number of iterations
+ * @param solver the solver
+ * @param iterations number of iterations (at least 1)
+ * @param diff set to the diff of the last iteration (may be NULL)
+ * @return the status
+ */
+solver_status stepSolver(heat_solver *solver, unsigned long iterations, double *diff)
+{
+    if (iterations == 0)
+    {
+        return SOLVER_INVALID;
+    }
+    // A diff of 0 is never below terminate 0: only the iterations stop the run
+    return runSolverUntil(solver, 0, iterations, diff, NULL);
+}
+
+/**
+ * Run iterations until the diff is below terminate, or max_iterations are run
+ * @param solver the solver
+ * @param terminate minimum diff to stop
+ * @param max_iterations number of iterations to stop, 0 for no limit (then terminate must be
+ * positive)
+ * @param diff set to the diff of the last iteration (may be NULL)
+ * @param iterations set to the number of iterations run (may be NULL)
+ * @return the status
+ */
+solver_status runSolverUntil(heat_solver *solver, double terminate, unsigned long max_iterations,
+                             double *diff, unsigned long *iterations)
+{
+    if (max_iterations == 0 && !(terminate > 0))
+    {
+        return SOLVER_INVALID;
+    }
+    unsigned long done;
+    double last = runSession(solver->session, terminate, max_iterations, &done);
+    if (diff != NULL)
+    {
+        *diff = last;
+    }
+    if (iterations != NULL)
+    {
+        *iterations = done;
+    }
+    if (last < 0)
+    {
+        return SOLVER_FAILED;
+    }
+    return sessionCancelled(solver->session) ? SOLVER_CANCELLED : SOLVER_OK;
+}
+
+/**
+ * Get the number of iterations run by a solver since it was created
+ * @param solver the solver
+ * @return the iterations
+ */
+unsigned long solverIterations(const heat_solver *solver)
+{
+    return sessionIterations(solver->session) - solver->start;
+}
+
+/**
+ * Describe a status
+ * @param status the status
+ * @return the description
+ */
+const char *solverMessage(solver_status status)
+{
+    switch (status)
+    {
+        case SOLVER_OK:
+            return "ok";
+        case SOLVER_INVALID:
+            return "invalid argument";
+        case SOLVER_UNSUPPORTED:
+            return "options not supported by a solver";
+        case SOLVER_NO_MEMORY:
+            return "out of memory";
+        case SOLVER_SETUP_FAILED:
+            return "the calculation could not be set up";
+        case SOLVER_TOO_MANY_SOURCES:
+            return "more sources than the solver has room for";
+        case SOLVER_FAILED:
+            return "a checkpoint could not be saved";
+        case SOLVER_CANCELLED:
+            return "cancelled";
+        default:
+            return "unknown status";
+    }
+}
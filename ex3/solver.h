@@ -0,0 +1,119 @@
+/**
+ * @file solver.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief The heat solver as a library
+ * @section DESCRIPTION
+ * A solver owns a grid and the working memory of its calculation (a calc_session), allocated
+ * when it is created: setting the sources and running the calculation allocate nothing, and
+ * the grid may be read and written between the runs. The functions return a status instead of
+ * exiting, and leave the solver usable after an error.
+ * A solver is used by one thread at a time.
+ */
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "calculator.h"
+
+/**
+ * Status of a call.
+ * SOLVER_INVALID is an argument out of range (a source outside of the grid, no stop
+ * condition...), SOLVER_UNSUPPORTED options a solver cannot run (tiling, multigrid or
+ * processes), SOLVER_NO_MEMORY a grid which could not be allocated, SOLVER_SETUP_FAILED a
+ * calculation which could not be set up (its working memory, the SIMD check, or a stencil
+ * which cannot run the scheme), SOLVER_TOO_MANY_SOURCES more sources than the solver has room
+ * for, SOLVER_FAILED a checkpoint which could not be saved, and SOLVER_CANCELLED a run stopped
+ * by the cancel flag of the options (the grid holds its last iteration).
+ */
+typedef enum
+{
+	SOLVER_OK,
+	SOLVER_INVALID,
+	SOLVER_UNSUPPORTED,
+	SOLVER_NO_MEMORY,
+	SOLVER_SETUP_FAILED,
+	SOLVER_TOO_MANY_SOURCES,
+	SOLVER_FAILED,
+	SOLVER_CANCELLED
+} solver_status;
+
+/**
+ * A solver: a grid and its calculation.
+ */
+typedef struct heat_solver heat_solver;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Create a solver of a n x m grid of zeros, without sources
+ * @param solver set to the solver, NULL on error
+ * @param function function to apply
+ * @param n height of the grid (at least 1)
+ * @param m width of the grid (at least 1)
+ * @param max_sources number of sources the solver has room for
+ * @param is_cyclic tell how to deal with borders
+ * @param options the options (NULL for the defaults), see openSession
+ * @return the status
+ */
+solver_status createSolver(heat_solver **solver, diff_func function, size_t n, size_t m,
+                           size_t max_sources, int is_cyclic, const calc_options *options);
+
+/**
+ * Free a solver and its grid
+ * @param solver the solver (may be NULL)
+ */
+void freeSolver(heat_solver *solver);
+
+/**
+ * Get the grid of a solver, to read or write it between runs
+ * @param solver the solver
+ * @return the grid
+ */
+heat_grid *solverGrid(heat_solver *solver);
+
+/**
+ * Replace the sources of a solver, and write their values to their cells
+ * @param solver the solver
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @return the status (the sources are unchanged on error)
+ */
+solver_status setSolverSources(heat_solver *solver, const source_point *sources,
+                               size_t num_sources);
+
+/**
+ * Run a number of iterations
+ * @param solver the solver
+ * @param iterations number of iterations (at least 1)
+ * @param diff set to the diff of the last iteration (may be NULL)
+ * @return the status
+ */
+solver_status stepSolver(heat_solver *solver, unsigned long iterations, double *diff);
+
+/**
+ * Run iterations until the diff is below terminate, or max_iterations are run
+ * @param solver the solver
+ * @param terminate minimum diff to stop
+ * @param max_iterations number of iterations to stop, 0 for no limit (then terminate must be
+ * positive)
+ * @param diff set to the diff of the last iteration (may be NULL)
+ * @param iterations set to the number of iterations run (may be NULL)
+ * @return the status
+ */
+solver_status runSolverUntil(heat_solver *solver, double terminate, unsigned long max_iterations,
+                             double *diff, unsigned long *iterations);
+
+/**
+ * Get the number of iterations run by a solver since it was created
+ * @param solver the solver
+ * @return the iterations
+ */
+unsigned long solverIterations(const heat_solver *solver);
+
+/**
+ * Describe a status
+ * @param status the status
+ * @return the description
+ */
+const char *solverMessage(solver_status status);
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file sources.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Build the per row index of the heat sources.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <string.h>
+#include "sources.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+// ------------------------------ functions -----------------------------
+
+/**
+ * Compare two columns, for qsort
+ * @param a first column
+ * @param b second column
+ * @return negative, 0 or positive as a is smaller, equal or bigger than b
+ */
+int compareCols(const void *a, const void *b)
+{
+    size_t first = *(const size_t *) a, second = *(const size_t *) b;
+    return (first > second) - (first < second);
+}
+
+/**
+ * Check if a source is inside the grid
+ * @param source the source
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return 1 iff inside
+ */
+int isInside(const source_point *source, size_t n, size_t m)
+{
+    return source->x >= 0 && source->y >= 0 && (size_t) source->x < n && (size_t) source->y < m;
+}
+
+/**
+ * Build the index of the sources inside a n x m grid (sources outside of it are ignored)
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the index, or NULL if the allocation failed
+ */
+source_index *buildSourceIndex(const source_point *sources, size_t num_sources, size_t n,
+                               size_t m)
+{
+    source_index *index = reserveSourceIndex(num_sources, n);
+    if (index != NULL)
+    {
+        fillSourceIndex(index, sources, num_sources, m);
+    }
+    return index;
+}
+
+/**
+ * Allocate an index of a n rows grid without sources, with room for some
+ * @param capacity number of sources it has room for
+ * @param n height of the grid
+ * @return the index, or NULL if the allocation failed
+ */
+source_index *reserveSourceIndex(size_t capacity, size_t n)
+{
+    source_index *index = (source_index *) malloc(sizeof(source_index));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+    index->n = n;
+    index->capacity = capacity;
+    index->rowStart = (size_t *) calloc(n + 1, sizeof(size_t));
+    index->cols = (size_t *) malloc(sizeof(size_t) * (capacity > 0 ? capacity : 1));
+    if (index->rowStart == NULL || index->cols == NULL)
+    {
+        freeSourceIndex(index);
+        return NULL;
+    }
+    return index;
+}
+
+/**
+ * Index other sources in an index, without allocating
+ * @param index the index, of a n rows grid
+ * @param sources sources list
+ * @param num_sources size of the list, at most the capacity of the index
+ * @param m width of the grid
+ * @return 1 iff they were indexed, 0 if there are too many of them (the index is unchanged)
+ */
+int fillSourceIndex(source_index *index, const source_point *sources, size_t num_sources,
+                    size_t m)
+{
+    if (num_sources > index->capacity)
+    {
+        return FALSE;
+    }
+    size_t n = index->n;
+    memset(index->rowStart, 0, sizeof(size_t) * (n + 1));
+    // Counting sort of the sources by row: rowStart[i + 1] ends up as the end of row i
+    for (size_t k = 0; k < num_sources; k++)
+    {
+        if (isInside(sources + k, n, m))
+        {
+            index->rowStart[sources[k].x + 1]++;
+        }
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        index->rowStart[i + 1] += index->rowStart[i];
+    }
+    for (size_t k = 0; k < num_sources; k++)
+    {
+        if (isInside(sources + k, n, m))
+        {
+            index->cols[index->rowStart[sources[k].x]++] = (size_t) sources[k].y;
+        }
+    }
+    // rowStart[i] is now the end of row i, shift it back while sorting and removing duplicates
+    size_t begin = 0, count = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t end = index->rowStart[i];
+        qsort(index->cols + begin, end - begin, sizeof(size_t), compareCols);
+        index->rowStart[i] = count;
+        for (size_t k = begin; k < end; k++)
+        {
+            if (k == begin || index->cols[k] != index->cols[k - 1])
+            {
+                index->cols[count++] = index->cols[k];
+            }
+        }
+        begin = end;
+    }
+    index->rowStart[n] = count;
+    return TRUE;
+}
+
+/**
+ * Free an index built with buildSourceIndex (NULL is ignored)
+ * @param index the index
+ */
+void freeSourceIndex(source_index *index)
+{
+    if (index == NULL)
+    {
+        return;
+    }
+    free(index->rowStart);
+    free(index->cols);
+    free(index);
+}
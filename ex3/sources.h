@@ -0,0 +1,65 @@
+/**
+ * @file sources.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Lookup structure for the heat sources
+ * @section DESCRIPTION
+ * The sources are indexed by row: for every row, the sorted columns of the sources in it.
+ * A sweep walks the columns of its row instead of looking every cell up in the sources list.
+ */
+#ifndef SOURCES_H
+#define SOURCES_H
+
+#include <stdlib.h>
+#include "calculator.h"
+
+/**
+ * Structure to hold the sources of a n rows grid.
+ * The columns of the sources in row i are cols[rowStart[i]] .. cols[rowStart[i + 1] - 1].
+ * cols has room for capacity sources.
+ */
+typedef struct
+{
+	size_t n;
+	size_t *rowStart;
+	size_t *cols;
+	size_t capacity;
+} source_index;
+
+/**
+ * Build the index of the sources inside a n x m grid (sources outside of it are ignored)
+ * @param sources sources list
+ * @param num_sources size of the list
+ * @param n height of the grid
+ * @param m width of the grid
+ * @return the index, or NULL if the allocation failed
+ */
+source_index *buildSourceIndex(const source_point *sources, size_t num_sources, size_t n,
+                               size_t m);
+
+/**
+ * Allocate an index of a n rows grid without sources, with room for some
+ * @param capacity number of sources it has room for
+ * @param n height of the grid
+ * @return the index, or NULL if the allocation failed
+ */
+source_index *reserveSourceIndex(size_t capacity, size_t n);
+
+/**
+ * Index other sources in an index, without allocating
+ * @param index the index, of a n rows grid
+ * @param sources sources list
+ * @param num_sources size of the list, at most the capacity of the index
+ * @param m width of the grid
+ * @return 1 iff they were indexed, 0 if there are too many of them (the index is unchanged)
+ */
+int fillSourceIndex(source_index *index, const source_point *sources, size_t num_sources,
+                    size_t m);
+
+/**
+ * Free an index built with buildSourceIndex (NULL is ignored)
+ * @param index the index
+ */
+void freeSourceIndex(source_index *index);
+
+#endif
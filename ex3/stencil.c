@@ -0,0 +1,415 @@
+/**
+ * @file stencil.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Linear stencils: presets, compilation for a grid and sweeps.
+ */
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include "stencil.h"
+// -------------------------- const definitions -------------------------
+#define TRUE 1
+#define FALSE 0
+#define HEAT_WEIGHT 0.25
+#define NINE_POINT_SIDE 0.2
+#define NINE_POINT_CORNER 0.05
+/**
+ * Number of cells of a Jacobi sweep whose points are added together.
+ */
+#define STENCIL_CHUNK 256
+// ------------------------------ structs -----------------------------
+
+/**
+ * The kernel: the points, with their flat offsets in the grid. The points of the cells of
+ * rows [top, n - bottom) and columns [left, m - right) are all inside the grid.
+ */
+struct stencil_kernel
+{
+    size_t count;
+    stencil_point points[STENCIL_MAX_POINTS];
+    ptrdiff_t offsets[STENCIL_MAX_POINTS];
+    size_t n, m;
+    size_t top, bottom, left, right;
+};
+
+// ------------------------------ functions -----------------------------
+
+/**
+ * Add a point to a stencil
+ * @param shape the stencil
+ * @param di row offset
+ * @param dj column offset
+ * @param weight weight of the cell
+ * @return 1 iff the stencil had room for it
+ */
+int addStencilPoint(stencil *shape, int di, int dj, double weight)
+{
+    if (shape->count >= STENCIL_MAX_POINTS)
+    {
+        return FALSE;
+    }
+    shape->points[shape->count].di = di;
+    shape->points[shape->count].dj = dj;
+    shape->points[shape->count].weight = weight;
+    shape->count++;
+    return TRUE;
+}
+
+/**
+ * Set the stencil of heat_eqn: the average of the 4 neighbors
+ * @param shape the stencil to set
+ */
+void heatStencil(stencil *shape)
+{
+    shape->count = 0;
+    addStencilPoint(shape, 0, 1, HEAT_WEIGHT);
+    addStencilPoint(shape, -1, 0, HEAT_WEIGHT);
+    addStencilPoint(shape, 0, -1, HEAT_WEIGHT);
+    addStencilPoint(shape, 1, 0, HEAT_WEIGHT);
+}
+
+/**
+ * Set the 9-point stencil of the steady heat equation
+ * @param shape the stencil to set
+ */
+void ninePointStencil(stencil *shape)
+{
+    heatStencil(shape);
+    for (size_t k = 0; k < shape->count; k++)
+    {
+        shape->points[k].weight = NINE_POINT_SIDE;
+    }
+    addStencilPoint(shape, -1, -1, NINE_POINT_CORNER);
+    addStencilPoint(shape, -1, 1, NINE_POINT_CORNER);
+    addStencilPoint(shape, 1, -1, NINE_POINT_CORNER);
+    addStencilPoint(shape, 1, 1, NINE_POINT_CORNER);
+}
+
+/**
+ * Set an anisotropic 5-point stencil
+ * @param shape the stencil to set
+ * @param ratio conductivity along the rows / conductivity along the columns (positive)
+ */
+void anisotropicStencil(stencil *shape, double ratio)
+{
+    double along = ratio / (2 * (1 + ratio)), across = 1 / (2 * (1 + ratio));
+    shape->count = 0;
+    addStencilPoint(shape, 0, 1, along);
+    addStencilPoint(shape, -1, 0, across);
+    addStencilPoint(shape, 0, -1, along);
+    addStencilPoint(shape, 1, 0, across);
+}
+
+/**
+ * Tell if a stencil is the one of heat_eqn (its points in any order)
+ * @param shape the stencil
+ * @return 1 iff it is
+ */
+int isHeatStencil(const stencil *shape)
+{
+    stencil heat;
+    heatStencil(&heat);
+    if (shape->count != heat.count)
+    {
+        return FALSE;
+    }
+    int found[STENCIL_MAX_POINTS] = {FALSE};
+    for (size_t k = 0; k < shape->count; k++)
+    {
+        const stencil_point *point = &shape->points[k];
+        size_t h = 0;
+        while (h < heat.count
+               && (found[h] || heat.points[h].di != point->di || heat.points[h].dj != point->dj
+                   || heat.points[h].weight != point->weight))
+        {
+            h++;
+        }
+        if (h == heat.count)
+        {
+            return FALSE;
+        }
+        found[h] = TRUE;
+    }
+    return TRUE;
+}
+
+/**
+ * Compile a stencil for a grid
+ * @param shape the stencil (at least one point)
+ * @param grid the grid, or any grid of the same size
+ * @return the kernel, or NULL if the stencil has no points or the allocation failed
+ */
+stencil_kernel *compileStencil(const stencil *shape, const heat_grid *grid)
+{
+    if (shape->count == 0 || shape->count > STENCIL_MAX_POINTS)
+    {
+        return NULL;
+    }
+    stencil_kernel *kernel = (stencil_kernel *) malloc(sizeof(stencil_kernel));
+    if (kernel == NULL)
+    {
+        return NULL;
+    }
+    kernel->count = shape->count;
+    kernel->n = grid->n;
+    kernel->m = grid->m;
+    kernel->top = kernel->bottom = kernel->left = kernel->right = 0;
+    for (size_t k = 0; k < shape->count; k++)
+    {
+        const stencil_point *point = &shape->points[k];
+        size_t rows = (size_t) labs(point->di), columns = (size_t) labs(point->dj);
+        kernel->points[k] = *point;
+        kernel->offsets[k] = (ptrdiff_t) point->di * (ptrdiff_t) grid->stride + point->dj;
+        if (point->di < 0 && rows > kernel->top)
+        {
+            kernel->top = rows;
+        }
+        if (point->di > 0 && rows > kernel->bottom)
+        {
+            kernel->bottom = rows;
+        }
+        if (point->dj < 0 && columns > kernel->left)
+        {
+            kernel->left = columns;
+        }
+        if (point->dj > 0 && columns > kernel->right)
+        {
+            kernel->right = columns;
+        }
+    }
+    return kernel;
+}
+
+/**
+ * Free a kernel
+ * @param kernel the kernel (may be NULL)
+ */
+void freeStencilKernel(stencil_kernel *kernel)
+{
+    free(kernel);
+}
+
+/**
+ * Get a coordinate of a point of a cell near a border
+ * @param coord coordinate of the cell
+ * @param offset offset of the point
+ * @param size size of the grid along the coordinate
+ * @param is_cyclic tell how to deal with borders
+ * @param inside set to 0 if the point is outside of the grid (and the grid is not cyclic)
+ * @return the coordinate of the point
+ */
+size_t pointCoord(size_t coord, int offset, size_t size, int is_cyclic, int *inside)
+{
+    long long target = (long long) coord + offset;
+    if (is_cyclic >= TRUE)
+    {
+        target %= (long long) size;
+        return (size_t) (target < 0 ? target + (long long) size : target);
+    }
+    if (target < 0 || target >= (long long) size)
+    {
+        *inside = FALSE;
+    }
+    return (size_t) target;
+}
+
+/**
+ * Apply a stencil on a cell near a border
+ * @param kernel the stencil
+ * @param grid the grid
+ * @param is_cyclic tell how to deal with borders
+ * @param i i coord
+ * @param j j coord
+ * @return the new value of the cell
+ */
+double updateStencilBorderCell(const stencil_kernel *kernel, const heat_grid *grid,
+                               int is_cyclic, size_t i, size_t j)
+{
+    double value = 0;
+    for (size_t k = 0; k < kernel->count; k++)
+    {
+        const stencil_point *point = &kernel->points[k];
+        int inside = TRUE;
+        size_t row = pointCoord(i, point->di, kernel->n, is_cyclic, &inside);
+        size_t column = pointCoord(j, point->dj, kernel->m, is_cyclic, &inside);
+        if (inside)
+        {
+            value += point->weight * GRID_AT(grid, row, column);
+        }
+    }
+    return value;
+}
+
+/**
+ * Update the inner cells [from, to) of a row one after the other. When the row to write is
+ * the row to read, every cell reads the ones updated before it.
+ * @param kernel the stencil
+ * @param out the row to write
+ * @param row the row to read
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void updateStencilCells(const stencil_kernel *kernel, double *out, const double *row,
+                        size_t from, size_t to, residual *change)
+{
+    for (size_t j = from; j < to; j++)
+    {
+        double value = 0;
+        for (size_t k = 0; k < kernel->count; k++)
+        {
+            value += kernel->points[k].weight * row[(ptrdiff_t) j + kernel->offsets[k]];
+        }
+        addChange(change, value - row[j]);
+        out[j] = value;
+    }
+}
+
+/**
+ * Update the inner cells [from, to) of a row from the previous values, a chunk of
+ * STENCIL_CHUNK cells at a time: the chunk adds up the cells of one point after the other, in
+ * loops of a fixed length which vectorise. The last cells are updated one after the other
+ * (with the same sums).
+ * @param kernel the stencil
+ * @param out the row to write
+ * @param row the row to read
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void updateStencilChunks(const stencil_kernel *kernel, double *out, const double *row,
+                         size_t from, size_t to, residual *change)
+{
+    double sums[STENCIL_CHUNK];
+    size_t start = from;
+    for (; start + STENCIL_CHUNK <= to; start += STENCIL_CHUNK)
+    {
+        for (size_t x = 0; x < STENCIL_CHUNK; x++)
+        {
+            sums[x] = 0;
+        }
+        for (size_t k = 0; k < kernel->count; k++)
+        {
+            double weight = kernel->points[k].weight;
+            const double *cells = row + (ptrdiff_t) start + kernel->offsets[k];
+            for (size_t x = 0; x < STENCIL_CHUNK; x++)
+            {
+                sums[x] += weight * cells[x];
+            }
+        }
+        if (change->norms)
+        {
+            for (size_t x = 0; x < STENCIL_CHUNK; x++)
+            {
+                addChange(change, sums[x] - row[start + x]);
+            }
+        }
+        else
+        {
+            double delta = change->delta;
+            for (size_t x = 0; x < STENCIL_CHUNK; x++)
+            {
+                delta += sums[x] - row[start + x];
+            }
+            change->delta = delta;
+        }
+        for (size_t x = 0; x < STENCIL_CHUNK; x++)
+        {
+            out[start + x] = sums[x];
+        }
+    }
+    updateStencilCells(kernel, out, row, start, to, change);
+}
+
+/**
+ * Update the cells [from, to) of a row near a border
+ * @param kernel the stencil
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void updateStencilBorder(const stencil_kernel *kernel, heat_grid *dst, const heat_grid *src,
+                         int is_cyclic, size_t i, size_t from, size_t to, residual *change)
+{
+    for (size_t j = from; j < to; j++)
+    {
+        double value = updateStencilBorderCell(kernel, src, is_cyclic, i, j);
+        addChange(change, value - GRID_AT(src, i, j));
+        GRID_AT(dst, i, j) = value;
+    }
+}
+
+/**
+ * Update the cells [from, to) of a row, none of them is a source
+ * @param kernel the stencil
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param is_cyclic tell how to deal with borders
+ * @param i row of the cells
+ * @param from first column
+ * @param to end column
+ * @param change the change of the sweep, updated
+ */
+void updateStencilSpan(const stencil_kernel *kernel, heat_grid *dst, const heat_grid *src,
+                       int is_cyclic, size_t i, size_t from, size_t to, residual *change)
+{
+    // The inner cells are [first, last), none when first == last == to
+    size_t first = to, last = to;
+    if (i >= kernel->top && i + kernel->bottom < kernel->n
+        && kernel->left + kernel->right < kernel->m)
+    {
+        first = from > kernel->left ? from : kernel->left;
+        last = to < kernel->m - kernel->right ? to : kernel->m - kernel->right;
+        if (first >= last)
+        {
+            first = last = to;
+        }
+    }
+    updateStencilBorder(kernel, dst, src, is_cyclic, i, from, first, change);
+    if (dst == src)
+    {
+        updateStencilCells(kernel, GRID_ROW(dst, i), GRID_ROW(src, i), first, last, change);
+    }
+    else
+    {
+        updateStencilChunks(kernel, GRID_ROW(dst, i), GRID_ROW(src, i), first, last, change);
+    }
+    updateStencilBorder(kernel, dst, src, is_cyclic, i, last, to, change);
+}
+
+/**
+ * Update the rows [from, to) of the grid with a stencil
+ * @param kernel the stencil compiled for the grid
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void updateStencilRows(const stencil_kernel *kernel, heat_grid *dst, const heat_grid *src,
+                       const source_index *index, int is_cyclic, size_t from, size_t to,
+                       residual *change)
+{
+    for (size_t i = from; i < to; i++)
+    {
+        const double *row = GRID_ROW(src, i);
+        double *out = GRID_ROW(dst, i);
+        size_t first = 0;
+        for (size_t k = index->rowStart[i]; k < index->rowStart[i + 1]; k++)
+        {
+            size_t source = index->cols[k];
+            updateStencilSpan(kernel, dst, src, is_cyclic, i, first, source, change);
+            out[source] = row[source];
+            first = source + 1;
+        }
+        updateStencilSpan(kernel, dst, src, is_cyclic, i, first, kernel->m, change);
+    }
+}
@@ -0,0 +1,94 @@
+/**
+ * @file stencil.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Linear stencils of the heat calculator
+ * @section DESCRIPTION
+ * A stencil lists the offsets of the cells a new value is made of, with their weights, so a
+ * 9-point or an anisotropic update needs no new function signature. It is compiled for the
+ * stride of a grid into a kernel: flat offsets from the cell, and the rows and columns whose
+ * points are all inside the grid. The inner cells of a row are then one strided loop per point
+ * (a Jacobi sweep adds the points of a chunk of cells at a time, which vectorises), and only
+ * the cells near the borders wrap around or read zeros.
+ * The cells outside of the grid are 0 (or wrap around if it is cyclic), the sources are kept
+ * as is, and the weighted values are added in the order of the points.
+ */
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include "kernel.h"
+
+/**
+ * A stencil compiled for a grid.
+ */
+typedef struct stencil_kernel stencil_kernel;
+
+// ------------------------------ functions -----------------------------
+/**
+ * Set the stencil of heat_eqn: the average of the 4 neighbors. It runs the heat_eqn sweeps.
+ * @param shape the stencil to set
+ */
+void heatStencil(stencil *shape);
+
+/**
+ * Set the 9-point stencil of the steady heat equation: the 4 neighbors weigh 1/5 and the 4
+ * diagonal ones 1/20.
+ * @param shape the stencil to set
+ */
+void ninePointStencil(stencil *shape);
+
+/**
+ * Set an anisotropic 5-point stencil: the heat flows ratio times faster along the rows than
+ * along the columns.
+ * @param shape the stencil to set
+ * @param ratio conductivity along the rows / conductivity along the columns (positive)
+ */
+void anisotropicStencil(stencil *shape, double ratio);
+
+/**
+ * Add a point to a stencil
+ * @param shape the stencil
+ * @param di row offset
+ * @param dj column offset
+ * @param weight weight of the cell
+ * @return 1 iff the stencil had room for it
+ */
+int addStencilPoint(stencil *shape, int di, int dj, double weight);
+
+/**
+ * Tell if a stencil is the one of heat_eqn (its points in any order)
+ * @param shape the stencil
+ * @return 1 iff it is
+ */
+int isHeatStencil(const stencil *shape);
+
+/**
+ * Compile a stencil for a grid
+ * @param shape the stencil (at least one point)
+ * @param grid the grid, or any grid of the same size
+ * @return the kernel, or NULL if the stencil has no points or the allocation failed
+ */
+stencil_kernel *compileStencil(const stencil *shape, const heat_grid *grid);
+
+/**
+ * Free a kernel
+ * @param kernel the kernel (may be NULL)
+ */
+void freeStencilKernel(stencil_kernel *kernel);
+
+/**
+ * Update the rows [from, to) of the grid with a stencil
+ * @param kernel the stencil compiled for the grid
+ * @param dst grid to write to (may be src)
+ * @param src grid to read from
+ * @param index the sources of the grid, which are copied as is
+ * @param is_cyclic tell how to deal with borders
+ * @param from first row
+ * @param to end row
+ * @param change the change of the sweep, updated
+ */
+void updateStencilRows(const stencil_kernel *kernel, heat_grid *dst, const heat_grid *src,
+                       const source_index *index, int is_cyclic, size_t from, size_t to,
+                       residual *change);
+
+#endif
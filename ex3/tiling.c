@@ -0,0 +1,57 @@
+/**
+ * @file tiling.c
+ * @author  benm
+ * @date 18 Oct 2026
+ * @section DESCRIPTION
+ * Wavefront schedule of several iterations.
+ */
+
+// ------------------------------ includes ------------------------------
+#include "tiling.h"
+// -------------------------- const definitions -------------------------
+#define FALSE 0
+#define IN_PLACE_LAG 1
+#define JACOBI_LAG 2
+// ------------------------------ functions -----------------------------
+
+/**
+ * Run iterations as a wavefront (see tiling.h)
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param grids grids[0] holds the latest values, grids[1] is the other grid of a Jacobi update
+ * @param jacobi 1 for a Jacobi update (then the latest values end in grids[count % 2])
+ * @param index the sources of the grid
+ * @param count number of iterations
+ * @param norms 1 to compute the norms of the changes too
+ * @param changes the change of every iteration
+ */
+void sweepWavefront(diff_func function, heat_interior_func interior, heat_grid *grids[2],
+                    int jacobi, const source_index *index, size_t count, int norms,
+                    residual *changes)
+{
+    size_t n = grids[0]->n;
+    size_t lag = jacobi ? JACOBI_LAG : IN_PLACE_LAG;
+    for (size_t t = 0; t < count; t++)
+    {
+        clearChange(&changes[t], norms);
+    }
+    if (n == 0 || count == 0)
+    {
+        return;
+    }
+    // At step s, iteration t updates row s - lag * t, the earlier iterations first
+    for (size_t s = 0; s < n + lag * (count - 1); s++)
+    {
+        for (size_t t = 0; t < count && lag * t <= s; t++)
+        {
+            size_t r = s - lag * t;
+            if (r >= n)
+            {
+                continue;
+            }
+            heat_grid *src = jacobi ? grids[t % 2] : grids[0];
+            heat_grid *dst = jacobi ? grids[(t + 1) % 2] : grids[0];
+            updateRows(function, interior, dst, src, index, FALSE, r, r + 1, &changes[t]);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+/**
+ * @file tiling.h
+ * @author  benm
+ * @date 18 Oct 2026
+ * @brief Temporal blocking of the heat calculator
+ * @section DESCRIPTION
+ * Several iterations of a grid without cyclic borders run together as a wavefront over the
+ * rows, so the rows in use stay in the cache instead of streaming the grid once per iteration.
+ */
+#ifndef TILING_H
+#define TILING_H
+
+#include "kernel.h"
+
+/**
+ * Run iterations as a wavefront: iteration t updates row r right after iteration t - 1
+ * updated row r + 1 (in place) or r + 2 (Jacobi), so only a band of about 2 * count rows is in
+ * use at a time. Every iteration still updates its rows in order and reads the same values as
+ * a full sweep, so the grid and the changes are exactly those of count sweeps.
+ * The borders must not be cyclic: the first row would read the last one of the previous
+ * iteration.
+ * @param function function to apply
+ * @param interior vector sweep of the inner cells of heat_eqn (Jacobi only), NULL for none
+ * @param grids grids[0] holds the latest values, grids[1] is the other grid of a Jacobi update
+ * @param jacobi 1 for a Jacobi update (then the latest values end in grids[count % 2])
+ * @param index the sources of the grid
+ * @param count number of iterations
+ * @param norms 1 to compute the norms of the changes too
+ * @param changes the change of every iteration
+ */
+void sweepWavefront(diff_func function, heat_interior_func interior, heat_grid *grids[2],
+                    int jacobi, const source_index *index, size_t count, int norms,
+                    residual *changes);
+
+#endif